@@ -0,0 +1,19 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @brief Runs the work the given number of times and returns the fastest run, in milliseconds.
+ * The fastest run is the one least disturbed by whatever else the machine was doing.
+ */
+template <typename Work>
+double fastestMilliseconds(int runs, Work work) {
+	double fastest = 0;
+	for (int run = 0; run < runs; run++) {
+		auto start = std::chrono::steady_clock::now();
+		work();
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fastest = run == 0 ? elapsed : std::min(fastest, elapsed);
+	}
+	return fastest;
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Bench.h"
+#include "Broadphase.h"
+
+/**
+ * Times finding the collision pairs among thousands of thrown rocks in the forest main() plants:
+ * 100 static trees, ten to a row, 20 apart along x, the rows 20 apart along z, so every tree
+ * shares its x range with the nine in the rows behind it. Reports the first findPairs, which
+ * sorts everything in, then the average step over the first second, with every rock in the
+ * air, and over the third, when friction has stopped most of them on the ground.
+ */
+
+namespace {
+	const int STEPS_PER_SECOND = 60;
+	const float DT = 1.0f / STEPS_PER_SECOND;
+	const glm::vec3 GRAVITY(0, -48, 0);
+	// What Physics slows bodies sliding on the ground by, in units per second squared.
+	const float FRICTION = 96;
+	const glm::vec3 TREE_HALF_EXTENT(4, 12.5f, 4);
+	const glm::vec3 ROCK_HALF_EXTENT(0.3f);
+
+	Aabb boxAround(const glm::vec3& center, const glm::vec3& halfExtent) {
+		Aabb box;
+		box.merge(center - halfExtent);
+		box.merge(center + halfExtent);
+		return box;
+	}
+
+	/**
+	 * @brief The trees where main() puts them.
+	 */
+	std::vector<glm::vec3> forest() {
+		std::vector<glm::vec3> trees;
+		glm::vec3 treePos(-50, 12.5f, -160);
+		trees.push_back(treePos);
+		for (int i = 1; i < 100; i++) {
+			trees.push_back(glm::vec3(treePos.x + 20, treePos.y, treePos.z));
+			treePos += glm::vec3(20, 0, 0);
+			if (treePos.x >= 100) {
+				treePos = glm::vec3(-100, treePos.y, treePos.z + 20);
+			}
+		}
+		return trees;
+	}
+}
+
+int main() {
+	auto trees = forest();
+	std::printf("%-7s %10s %12s %12s %8s\n", "rocks", "first ms", "flying ms", "landed ms", "pairs");
+	for (uint32_t rockCount : { 1000, 5000, 20000 }) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> x(-110, 110);
+		std::uniform_real_distribution<float> y(0, 20);
+		std::uniform_real_distribution<float> z(-170, 30);
+		std::uniform_real_distribution<float> direction(-1, 1);
+
+		Broadphase broadphase;
+		uint32_t index = 0;
+		for (auto& tree : trees) {
+			broadphase.insert(Entity{ index++, 0 }, boxAround(tree, TREE_HALF_EXTENT), true);
+		}
+		// Rocks are thrown at 50 units a second, as throwRock does.
+		std::vector<glm::vec3> positions, velocities;
+		for (uint32_t i = 0; i < rockCount; i++) {
+			positions.push_back(glm::vec3(x(random), y(random), z(random)));
+			velocities.push_back(glm::normalize(glm::vec3(direction(random), direction(random), direction(random))) * 50.0f);
+			broadphase.insert(Entity{ index++, 0 }, boxAround(positions.back(), ROCK_HALF_EXTENT), false);
+		}
+		auto boxOf = [&](Entity entity) { return boxAround(positions[entity.index - trees.size()], ROCK_HALF_EXTENT); };
+
+		double first = fastestMilliseconds(1, [&]() { broadphase.findPairs(); });
+		double seconds[3] = {};
+		size_t pairs = 0;
+		for (int step = 0; step < 3 * STEPS_PER_SECOND; step++) {
+			for (uint32_t i = 0; i < rockCount; i++) {
+				auto& position = positions[i];
+				auto& velocity = velocities[i];
+				if (position.y == 0) {
+					// Sliding along the ground until friction stops it.
+					float speed = std::sqrt(velocity.x * velocity.x + velocity.z * velocity.z);
+					float slowed = std::max(speed - FRICTION * DT, 0.0f);
+					velocity *= speed > 0 ? slowed / speed : 0;
+				}
+				else {
+					velocity += GRAVITY * DT;
+				}
+				position += velocity * DT;
+				if (position.y < 0) {
+					position.y = 0;
+					velocity.y = 0;
+				}
+			}
+			broadphase.refresh(boxOf);
+			seconds[step / STEPS_PER_SECOND] += fastestMilliseconds(1, [&]() { pairs = broadphase.findPairs().size(); });
+		}
+		std::printf("%-7u %10.3f %12.3f %12.3f %8zu\n", rockCount, first, seconds[0] / STEPS_PER_SECOND,
+			seconds[2] / STEPS_PER_SECOND, pairs);
+	}
+	return 0;
+}
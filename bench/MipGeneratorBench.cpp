@@ -0,0 +1,106 @@
+#include <glad/glad.h>
+#include <SFML/Window/Context.hpp>
+#include <cstdio>
+#include <vector>
+#include "Bench.h"
+#include "MipGenerator.h"
+
+/**
+ * Times building full mip chains with each CPU kernel, then compares the CPU path the texture
+ * cooker takes (build the chain, upload every level) with uploading only the base level and
+ * running glGenerateMipmap, both waited on with glFinish.
+ */
+
+namespace {
+	const int RUNS = 5;
+
+	const char* kernelName(MipKernel kernel) {
+		switch (kernel) {
+		case MipKernel::SSE2:
+			return "SSE2";
+		case MipKernel::AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+		}
+	}
+
+	GLenum internalFormatFor(int32_t channels) {
+		const GLenum formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+		return formats[channels - 1];
+	}
+
+	GLenum pixelFormatFor(int32_t channels) {
+		const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+		return formats[channels - 1];
+	}
+
+	void upload(const MipImage& image, GLint level) {
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormatFor(image.channels), image.width, image.height, 0,
+			pixelFormatFor(image.channels), GL_UNSIGNED_BYTE, image.pixels);
+	}
+}
+
+int main() {
+	sf::ContextSettings settings;
+	settings.majorVersion = 3;
+	settings.minorVersion = 3;
+	sf::Context context(settings, 1, 1);
+	bool hasGL = context.setActive(true) && gladLoadGL();
+	GLuint texture = 0;
+	if (hasGL) {
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	}
+	else {
+		std::printf("No OpenGL context; skipping the glGenerateMipmap comparison\n");
+	}
+
+	std::printf("%-11s %-8s %-30s %10s\n", "size", "channels", "path", "ms");
+	for (int32_t size : { 1024, 2048, 4096 }) {
+		for (int32_t channels = 1; channels <= 4; channels++) {
+			std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * channels);
+			for (size_t i = 0; i < pixels.size(); i++) {
+				pixels[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+			}
+			MipImage source;
+			source.width = size;
+			source.height = size;
+			source.channels = channels;
+			source.pixels = pixels.data();
+
+			auto report = [&](const char* path, double milliseconds) {
+				std::printf("%5dx%-5d %-8d %-30s %10.2f\n", size, size, channels, path, milliseconds);
+			};
+			for (auto kernel : { MipKernel::Scalar, MipKernel::SSE2, MipKernel::AVX2 }) {
+				if (kernel > bestMipKernel()) {
+					continue;
+				}
+				report(kernelName(kernel), fastestMilliseconds(RUNS, [&]() { generateMipChain(source, kernel); }));
+			}
+			if (!hasGL) {
+				continue;
+			}
+
+			report("CPU chain + upload every level", fastestMilliseconds(RUNS, [&]() {
+				upload(source, 0);
+				GLint level = 1;
+				for (auto& mip : generateMipChain(source)) {
+					upload(mip, level++);
+				}
+				glFinish();
+			}));
+			report("upload + glGenerateMipmap", fastestMilliseconds(RUNS, [&]() {
+				upload(source, 0);
+				glGenerateMipmap(GL_TEXTURE_2D);
+				glFinish();
+			}));
+		}
+	}
+
+	if (hasGL) {
+		glDeleteTextures(1, &texture);
+	}
+	return 0;
+}
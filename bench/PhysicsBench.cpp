@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <random>
+#include "Bench.h"
+#include "Physics.h"
+
+/**
+ * Times one integration step of every body with each kernel, for a mix of bodies in the air,
+ * sliding along the ground and at rest on it.
+ */
+
+namespace {
+	const int RUNS = 20;
+	const float DT = 1.0f / 60;
+
+	const char* kernelName(PhysicsKernel kernel) {
+		return kernel == PhysicsKernel::AVX ? "AVX" : "scalar";
+	}
+
+	void fill(PhysicsBodies& bodies, uint32_t count) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> coordinate(-100, 100);
+		for (uint32_t i = 0; i < count; i++) {
+			PhysicsBody body;
+			glm::vec3 position(coordinate(random), 0, coordinate(random));
+			switch (random() % 3) {
+			case 0:
+				position.y = 50 + coordinate(random);
+				body.velocity = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+				break;
+			case 1:
+				body.velocity = glm::vec3(coordinate(random), 0, coordinate(random));
+				break;
+			default:
+				break;
+			}
+			bodies.insert(Entity{ i, 0 }, body);
+			bodies.setPositionAt(i, position);
+		}
+	}
+}
+
+int main() {
+	std::printf("%-9s %-8s %10s %12s\n", "bodies", "kernel", "ms", "ns/body");
+	for (uint32_t count : { 10000, 100000, 1000000 }) {
+		for (auto kernel : { PhysicsKernel::Scalar, PhysicsKernel::AVX }) {
+			if (kernel > bestPhysicsKernel()) {
+				continue;
+			}
+			// Bodies fall and stop as the steps go by, so every kernel starts from the same state.
+			PhysicsBodies bodies;
+			fill(bodies, count);
+			double milliseconds = fastestMilliseconds(RUNS, [&]() { integrateBodies(bodies, DT, kernel); });
+			std::printf("%-9u %-8s %10.3f %12.2f\n", count, kernelName(kernel), milliseconds, milliseconds * 1e6 / count);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "Bench.h"
+#include "TransformKernel.h"
+
+/**
+ * Times composing batches of 1k, 100k and 1M local matrices: with the chain of glm calls objects
+ * used to be built with, and with each kernel this CPU has.
+ */
+
+namespace {
+	const int RUNS = 5;
+
+	const char* kernelName(TransformKernel kernel) {
+		switch (kernel) {
+		case TransformKernel::SSE:
+			return "SSE";
+		case TransformKernel::AVX:
+			return "AVX";
+		default:
+			return "scalar";
+		}
+	}
+}
+
+int main() {
+	std::printf("%-10s %-10s %10s %12s\n", "count", "path", "ms", "ns/matrix");
+	for (size_t count : { size_t(1000), size_t(100000), size_t(1000000) }) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(-1, 1);
+		std::vector<glm::vec3> positions(count), eulers(count), scales(count), centers(count);
+		std::vector<glm::mat4> bases(count, glm::mat4(1));
+		std::vector<glm::mat4> results(count);
+		std::vector<uint32_t> indices(count);
+		std::iota(indices.begin(), indices.end(), 0);
+		TransformBatch batch;
+		batch.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			positions[i] = glm::vec3(unit(random), unit(random), unit(random)) * 50.0f;
+			eulers[i] = glm::vec3(unit(random), unit(random), unit(random)) * 3.0f;
+			scales[i] = glm::vec3(1.5f) + glm::vec3(unit(random), unit(random), unit(random));
+			centers[i] = glm::vec3(unit(random), unit(random), unit(random));
+			if (i % 2 == 0) {
+				bases[i] = glm::translate(glm::mat4(1), centers[i]);
+			}
+			batch.set(i, positions[i], orientationFromEuler(eulers[i]), scales[i], centers[i]);
+		}
+
+		auto report = [&](const char* path, double milliseconds) {
+			std::printf("%-10zu %-10s %10.3f %12.2f\n", count, path, milliseconds, milliseconds * 1e6 / count);
+		};
+		report("glm chain", fastestMilliseconds(RUNS, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				auto m = glm::translate(glm::mat4(1), positions[i]);
+				m = glm::translate(m, centers[i] * scales[i]);
+				m = glm::rotate(m, eulers[i].z, glm::vec3(0, 0, 1));
+				m = glm::rotate(m, eulers[i].x, glm::vec3(1, 0, 0));
+				m = glm::rotate(m, eulers[i].y, glm::vec3(0, 1, 0));
+				m = glm::scale(m, scales[i]);
+				m = glm::translate(m, -centers[i]);
+				results[i] = m * bases[i];
+			}
+		}));
+		for (auto kernel : { TransformKernel::Scalar, TransformKernel::SSE, TransformKernel::AVX }) {
+			if (kernel > bestTransformKernel()) {
+				continue;
+			}
+			report(kernelName(kernel), fastestMilliseconds(RUNS, [&]() {
+				composeTransforms(batch.columns(), bases.data(), indices.data(), results.data(), kernel);
+			}));
+		}
+	}
+	return 0;
+}
@@ -1,16 +1,18 @@
 #pragma once
-#include "Object3D.h"
+#include "Entity.h"
 
 /**
 * @brief Represents an abstract animation of an object, manipulating one or more of its
-* attributes over a duration.
+* attributes over a duration. The object is identified by its entity, so the animation keeps
+* working when the object itself is moved into a list or another object, and does nothing once
+* the entity is destroyed.
 * This is an abstract class that cannot be instantiated.
 */
 class Animation {
 private:
 	float m_duration;
 	float m_currentTime;
-	Object3D& m_object;
+	Entity m_node;
 
 	/**
 	 * @brief Called when the animation is activated by an Animator.
@@ -23,7 +25,7 @@ private:
 	virtual void applyAnimation(float dt) = 0;
 
 public:
-	Animation(Object3D& obj, float duration) : m_object(obj), m_duration(duration),
+	Animation(Entity node, float duration) : m_node(node), m_duration(duration),
 		m_currentTime(-1) {
 	}
 
@@ -38,9 +40,9 @@ public:
 	float currentTime() const { return m_currentTime; }
 
 	/**
-	* @brief The object the animation is manipulating.
+	* @brief The node the animation is manipulating.
 	*/
-	Object3D& object() const { return m_object; }
+	Entity node() const { return m_node; }
 
 	/**
 	* @brief Advances the animation by the given interval, in seconds.
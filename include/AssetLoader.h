@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include "ModelData.h"
+#include "Object3D.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief A two-stage model loading pipeline.
+ * Stage one runs on a ThreadPool: the Assimp import (or mesh cache read), vertex and index
+ * building, and decoding (through the TextureService) of every texture image the model references.
+ * Stage two runs on the GL thread, in uploadReady() or waitForAny(), and only uploads the
+ * finished buffers and images.
+ */
+class AssetLoader {
+public:
+	using LoadedCallback = std::function<void(const std::string& key, Object3D&& object)>;
+
+private:
+	/**
+	 * @brief A model moving through the pipeline.
+	 */
+	struct PendingModel {
+		std::string key;
+		std::string path;
+		uint32_t importFlags;
+		ModelData model;
+		// How many of this model's textures are still decoding, plus one while they are being requested.
+		std::atomic<size_t> remainingImages;
+		// Set if any stage one work failed; rethrown on the GL thread.
+		std::exception_ptr error;
+		std::mutex errorMutex;
+	};
+
+	ThreadPool& m_pool;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_readyChanged;
+	// Keys that have been requested but not yet uploaded.
+	std::unordered_set<std::string> m_pending;
+	// Models whose stage one work has finished, waiting for the GL thread.
+	std::deque<std::shared_ptr<PendingModel>> m_ready;
+	// Stage one tasks still referencing this loader.
+	size_t m_inFlight;
+
+	void importModel(std::shared_ptr<PendingModel> pending);
+	void imageDecoded(std::shared_ptr<PendingModel> pending);
+	void finishStageOne(std::shared_ptr<PendingModel> pending);
+	void fail(PendingModel& pending, std::exception_ptr error);
+	size_t upload(std::deque<std::shared_ptr<PendingModel>>& ready, const LoadedCallback& onLoaded);
+
+public:
+	explicit AssetLoader(ThreadPool& pool);
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	/**
+	 * @brief Starts loading a model in the background. Requesting a key that is already pending
+	 * does nothing.
+	 */
+	void request(const std::string& key, const std::string& path, uint32_t importFlags);
+
+	/**
+	 * @brief Whether the given key has been requested but not yet uploaded.
+	 */
+	bool isPending(const std::string& key) const;
+
+	/**
+	 * @brief Whether any requested model has not yet been uploaded.
+	 */
+	bool hasPending() const;
+
+	/**
+	 * @brief Uploads every model that has finished stage one, without blocking.
+	 * Must be called on the GL thread. Returns how many models were uploaded.
+	 */
+	size_t uploadReady(const LoadedCallback& onLoaded);
+
+	/**
+	 * @brief Blocks until at least one pending model has finished stage one, then uploads every
+	 * ready model. Returns immediately if nothing is pending. Must be called on the GL thread.
+	 */
+	size_t waitForAny(const LoadedCallback& onLoaded);
+};
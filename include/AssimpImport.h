@@ -1,10 +1,26 @@
 #pragma once
 #include "Object3D.h"
+#include "ModelData.h"
 #include <assimp/scene.h>
 #include <unordered_map>
 #include <filesystem>
 
 Object3D assimpLoad(const std::string& path, bool flipUVCoords);
-Object3D processAssimpNode(aiNode* node, const aiScene* scene,
-	const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
\ No newline at end of file
+
+/**
+ * @brief The Assimp post-processing flags assimpLoad uses for a model.
+ */
+uint32_t assimpImportFlags(bool flipUVCoords);
+
+/**
+ * @brief Produces the CPU-side description of a model, from the mesh cache if it is up to date
+ * and otherwise by importing it with Assimp (and then refreshing the cache).
+ */
+ModelData loadModelData(const std::string& path, uint32_t importFlags);
+
+/**
+ * @brief Uploads a model's meshes and textures to the GPU and builds its Object3D hierarchy.
+ */
+Object3D buildObject(const ModelData& model, const std::filesystem::path& modelPath);
+
+void processAssimpNode(aiNode* node, int32_t parent, ModelData& model);
@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/ext.hpp>
+
+/**
+ * @brief A sphere enclosing some geometry; what the frustum culler tests.
+ */
+struct BoundingSphere {
+	glm::vec3 center;
+	float radius;
+};
+
+/**
+ * @brief A sphere enclosing the given sphere after transforming it by the given matrix; the
+ * radius grows by the largest of the matrix's scale factors.
+ */
+inline BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& transform) {
+	float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+		glm::length(glm::vec3(transform[2])) });
+	return BoundingSphere{ glm::vec3(transform * glm::vec4(sphere.center, 1)), sphere.radius * scale };
+}
+
+/**
+ * @brief An axis-aligned bounding box. A default-constructed box is empty and merges as a no-op.
+ */
+struct Aabb {
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+	bool isEmpty() const {
+		return min.x > max.x;
+	}
+
+	void merge(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void merge(const Aabb& other) {
+		if (!other.isEmpty()) {
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+	}
+
+	glm::vec3 center() const {
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 halfExtent() const {
+		return (max - min) * 0.5f;
+	}
+
+	/**
+	 * @brief The sphere around this box, after transforming it by the given matrix. Cheaper
+	 * and looser than transforming the box itself.
+	 */
+	BoundingSphere sphere(const glm::mat4& transform) const {
+		return transformSphere(BoundingSphere{ center(), glm::length(halfExtent()) }, transform);
+	}
+
+	/**
+	 * @brief The box around this box's eight corners after transforming them by the given matrix.
+	 */
+	Aabb transformed(const glm::mat4& transform) const {
+		Aabb result;
+		if (isEmpty()) {
+			return result;
+		}
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+			result.merge(glm::vec3(transform * glm::vec4(point, 1)));
+		}
+		return result;
+	}
+};
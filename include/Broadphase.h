@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Bounds.h"
+#include "Entity.h"
+
+/**
+ * @brief Two colliders whose boxes overlap, and so might be touching.
+ */
+struct CollisionPair {
+	Entity first;
+	Entity second;
+};
+
+/**
+ * @brief Finds the pairs of colliders whose world-space boxes overlap, by sweep and prune: the
+ * boxes' ends along each of x, y and z are kept in a sorted list, and the set of overlapping
+ * pairs is kept with them. The lists persist between steps and objects move little in one, so
+ * re-sorting them is an insertion sort, and each time it swaps a min and a max, whether two
+ * boxes overlap along that axis has changed. Only those swaps add or remove pairs, so a step
+ * costs about as much as the colliders moved, however many boxes share their range along an
+ * axis, as the rows of trees do along x.
+ *
+ * When things move so far in a step that the swaps would cost more than finding every pair
+ * again, the pairs are instead found with one sweep along the axis the boxes are most spread
+ * out on, until they slow down. New colliders, and colliders that become or stop being static,
+ * are sorted in all at once and swept for the same way.
+ *
+ * Static colliders never move, and are never paired with each other.
+ */
+class Broadphase {
+private:
+	static constexpr uint32_t ABSENT = UINT32_MAX;
+	// About what a min and a max swapping costs when the pairs are updated, counting the swaps
+	// around it and the pair lookup, in box tests of a sweep.
+	static constexpr float CROSSING_COST = 2;
+
+	struct Proxy {
+		Entity entity;
+		Aabb box;
+		bool isStatic;
+		// Where the proxy is in m_open during a sweep.
+		uint32_t openIndex;
+		// How many pairs it is in, so most swaps can tell it is in none without a lookup.
+		uint32_t pairCount;
+	};
+
+	/**
+	 * @brief One end of a proxy's box along one axis. The box's value is copied here so the sort
+	 * reads only this array.
+	 */
+	struct Endpoint {
+		float value;
+		// The proxy, shifted left one bit; the low bit is set for the max end.
+		uint32_t proxyAndEnd;
+
+		uint32_t proxy() const { return proxyAndEnd >> 1; }
+		bool isMax() const { return (proxyAndEnd & 1) != 0; }
+		// At equal values, min ends go first, so boxes that only touch still overlap.
+		bool operator<(const Endpoint& other) const {
+			return value < other.value || (value == other.value && isMax() < other.isMax());
+		}
+	};
+
+	/**
+	 * @brief A box the sweep is inside of, with its extent along the other two axes copied out so
+	 * the tests against it read only m_open.
+	 */
+	struct OpenBox {
+		float otherMin;
+		float otherMax;
+		float lastMin;
+		float lastMax;
+		uint32_t proxy;
+		bool isStatic;
+	};
+
+	std::vector<Proxy> m_proxies;
+	std::vector<uint32_t> m_freeProxies;
+	// The proxy of each entity index, or ABSENT.
+	std::vector<uint32_t> m_proxyOf;
+	// The ends of every box along x, y and z.
+	std::vector<Endpoint> m_endpoints[3];
+	// Set when proxies were added or changed kind, so the next step sorts from scratch and
+	// sweeps.
+	bool m_rebuild = false;
+	// Set while the boxes move far enough each step that updating the pairs would take more work
+	// than finding them again with a sweep. Then only the sweep axis is kept sorted, and the
+	// times a min and a max swap along it are counted to tell when updating would be cheaper.
+	bool m_sweeping = false;
+	int m_sweepAxis = 0;
+	// How many pairs of boxes the last sweep tested.
+	size_t m_sweepTests = 0;
+	// How many mins and maxes swapped along every axis for each that swapped along the sweep axis,
+	// the last time the pairs were updated. Boxes falling through a crowd on the ground cross
+	// far more often along y than along x, and sweeping only counts the sweep axis.
+	float m_crossingRatio = 3;
+	// The boxes the sweep is inside of; kept to reuse its storage.
+	std::vector<OpenBox> m_open;
+	std::vector<CollisionPair> m_pairs;
+	// The two proxies of each pair in m_pairs, as pairKey makes them, and where each pair is in
+	// m_pairs by its key. Only kept while the pairs are updated rather than swept for: m_indexed
+	// says whether they, and the proxies' pair counts, are up to date.
+	std::vector<uint64_t> m_pairKeys;
+	std::unordered_map<uint64_t, uint32_t> m_pairIndex;
+	bool m_indexed = false;
+
+	static uint64_t pairKey(uint32_t a, uint32_t b) {
+		return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+	}
+
+	uint32_t proxyOf(Entity entity) const;
+	// Whether the two proxies' boxes overlap on every axis, and they may be paired at all.
+	bool overlaps(uint32_t a, uint32_t b) const;
+	// Whether the two proxies' boxes overlap on every axis after the given one.
+	bool overlapsAfter(uint32_t a, uint32_t b, int axis) const;
+	void indexPairs();
+	void addPair(uint32_t a, uint32_t b);
+	void removePair(uint32_t a, uint32_t b);
+	void removePairsOf(uint32_t proxy);
+	// Copies each box's ends along the axis into its endpoints.
+	void loadValues(int axis);
+	// Adds or removes the pair of boxes whose min and max just swapped along the axis, the first
+	// having moved down past the second.
+	void swapPairs(Endpoint moved, Endpoint passed, int axis);
+	// Insertion-sorts the axis's endpoints, and returns how many times a min and a max swapped.
+	// If told to, updates the pairs as they swap; a compile-time choice, since the sort is the
+	// inner loop of every step.
+	template <bool UPDATE_PAIRS>
+	size_t sortAxis(int axis);
+	// Picks the axis the boxes' centers are most spread out on, so the fewest share each range.
+	void chooseSweepAxis();
+	// Finds every pair again along the sorted sweep axis.
+	void sweep();
+	// Sorts the other two axes from scratch, so the pairs can be updated from the next step.
+	void startUpdating();
+
+public:
+	/**
+	 * @brief Adds the entity as a collider with the given box, or updates it if it is one already.
+	 */
+	void insert(Entity entity, const Aabb& box, bool isStatic);
+
+	/**
+	 * @brief Stops the entity colliding, if it does.
+	 */
+	void remove(Entity entity);
+
+	bool contains(Entity entity) const {
+		return proxyOf(entity) != ABSENT;
+	}
+
+	size_t size() const { return m_endpoints[0].size() / 2; }
+
+	/**
+	 * @brief Recomputes the box of every collider that isn't static, as boxOf(entity).
+	 */
+	template <typename BoxOf>
+	void refresh(BoxOf boxOf) {
+		for (auto& proxy : m_proxies) {
+			if (!proxy.entity.isNull() && !proxy.isStatic) {
+				proxy.box = boxOf(proxy.entity);
+			}
+		}
+	}
+
+	/**
+	 * @brief Every pair of colliders whose boxes overlap, at least one of them not static, in no
+	 * particular order. Good until the next call.
+	 */
+	const std::vector<CollisionPair>& findPairs();
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <glm/ext.hpp>
+#include "ShaderProgram.h"
+
+/**
+ * @brief A first-person camera that publishes its matrices through the std140 Camera uniform block.
+ * Input only moves and turns the camera; the view, projection and view-projection matrices are
+ * rebuilt at most once per frame by update(), which uploads them to a single uniform buffer bound
+ * to CAMERA_BINDING. Every program that declares the Camera block reads that buffer, so adding
+ * programs adds no uploads.
+ */
+class Camera {
+private:
+	/**
+	 * @brief The CPU mirror of the Camera uniform block.
+	 */
+	struct CameraBlock {
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		glm::vec3 position;
+		float padding;
+	};
+
+	glm::vec3 m_position;
+	glm::vec3 m_front;
+	glm::vec3 m_up;
+	// Euler angles in degrees; a yaw of -90 looks down the negative z axis.
+	float m_yaw;
+	float m_pitch;
+
+	float m_fieldOfView;
+	float m_aspectRatio;
+	float m_near;
+	float m_far;
+
+	CameraBlock m_block;
+	uint32_t m_buffer;
+	bool m_viewDirty;
+	bool m_projectionDirty;
+
+public:
+	// The uniform buffer binding point the Camera block is bound to.
+	static const uint32_t CAMERA_BINDING = 1;
+
+	/**
+	 * @brief Constructs a camera at the given position, looking down the negative z axis.
+	 * @param fieldOfView the vertical field of view, in degrees.
+	 */
+	Camera(const glm::vec3& position, float fieldOfView, float aspectRatio, float nearPlane, float farPlane);
+	~Camera();
+	Camera(Camera&& other) noexcept;
+	Camera(const Camera&) = delete;
+	Camera& operator=(const Camera&) = delete;
+	Camera& operator=(Camera&&) = delete;
+
+	/**
+	 * @brief Points a program's Camera block at this camera's buffer. Programs without the
+	 * block are left alone.
+	 */
+	void attach(ShaderProgram& program) const;
+
+	/**
+	 * @brief Turns the camera by the given yaw and pitch, in degrees. Pitch is clamped to
+	 * (-89, 89) so the camera never flips over.
+	 */
+	void turn(float deltaYaw, float deltaPitch);
+
+	/**
+	 * @brief Moves the camera by the given world-space offset.
+	 */
+	void move(const glm::vec3& offset);
+
+	void setAspectRatio(float aspectRatio);
+
+	/**
+	 * @brief Rebuilds whichever matrices the input since the last update invalidated, and uploads
+	 * the Camera block if any changed. Call once per frame, after input and before drawing.
+	 * @return true if the view changed, i.e. the camera moved or turned.
+	 */
+	bool update();
+
+	const glm::vec3& getPosition() const;
+	const glm::vec3& getFront() const;
+	const glm::vec3& getUp() const;
+	float getFarPlane() const;
+
+	// The matrices as of the last update().
+	const glm::mat4& getView() const;
+	const glm::mat4& getProjection() const;
+	const glm::mat4& getViewProjection() const;
+};
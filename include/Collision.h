@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+#include "World.h"
+
+/**
+ * @brief The box around a root entity's whole hierarchy in world space, from the bounds of its
+ * meshes and its current transform, which the last step may have changed since it was drawn.
+ */
+Aabb colliderBox(const World& world, Entity root);
+
+/**
+ * @brief Brings the box of every collider that can move up to date, and returns the pairs of
+ * colliders whose boxes overlap: the candidates for an exact test. Good until the next call.
+ */
+const std::vector<CollisionPair>& findCollisionCandidates(World& world);
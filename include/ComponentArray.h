@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Entity.h"
+
+/**
+ * @brief One kind of component for any number of entities, stored densely: the components are
+ * contiguous in one vector, with no gaps for entities that don't have one, so a system can walk
+ * them as a plain array. A sparse table from entity index to dense position makes lookups
+ * constant time. Removing swaps the last component into the gap, so the order is not stable.
+ */
+template <typename T>
+class ComponentArray {
+private:
+	static constexpr uint32_t ABSENT = UINT32_MAX;
+
+	// Dense position of each entity index's component, or ABSENT.
+	std::vector<uint32_t> m_sparse;
+	std::vector<Entity> m_entities;
+	std::vector<T> m_components;
+
+	uint32_t positionOf(Entity entity) const {
+		if (entity.index >= m_sparse.size()) {
+			return ABSENT;
+		}
+		auto position = m_sparse[entity.index];
+		// A stale handle whose index has been reused by another entity.
+		if (position != ABSENT && m_entities[position] != entity) {
+			return ABSENT;
+		}
+		return position;
+	}
+
+public:
+	/**
+	 * @brief Gives the entity the component, replacing any it already had.
+	 */
+	T& insert(Entity entity, T component) {
+		auto position = positionOf(entity);
+		if (position != ABSENT) {
+			m_components[position] = std::move(component);
+			return m_components[position];
+		}
+		if (entity.index >= m_sparse.size()) {
+			m_sparse.resize(entity.index + 1, ABSENT);
+		}
+		m_sparse[entity.index] = static_cast<uint32_t>(m_components.size());
+		m_entities.push_back(entity);
+		m_components.push_back(std::move(component));
+		return m_components.back();
+	}
+
+	/**
+	 * @brief Removes the entity's component, if it has one.
+	 */
+	void remove(Entity entity) {
+		auto position = positionOf(entity);
+		if (position == ABSENT) {
+			return;
+		}
+		auto last = static_cast<uint32_t>(m_components.size() - 1);
+		if (position != last) {
+			m_components[position] = std::move(m_components[last]);
+			m_entities[position] = m_entities[last];
+			m_sparse[m_entities[position].index] = position;
+		}
+		m_components.pop_back();
+		m_entities.pop_back();
+		m_sparse[entity.index] = ABSENT;
+	}
+
+	bool contains(Entity entity) const {
+		return positionOf(entity) != ABSENT;
+	}
+
+	/**
+	 * @brief The entity's component, or null if it has none.
+	 */
+	T* find(Entity entity) {
+		auto position = positionOf(entity);
+		return position == ABSENT ? nullptr : &m_components[position];
+	}
+
+	const T* find(Entity entity) const {
+		auto position = positionOf(entity);
+		return position == ABSENT ? nullptr : &m_components[position];
+	}
+
+	/**
+	 * @brief The entity's component.
+	 * @throws std::out_of_range if it has none.
+	 */
+	T& get(Entity entity) {
+		auto component = find(entity);
+		if (component == nullptr) {
+			throw std::out_of_range("Entity has no such component");
+		}
+		return *component;
+	}
+
+	const T& get(Entity entity) const {
+		return const_cast<ComponentArray*>(this)->get(entity);
+	}
+
+	size_t size() const { return m_components.size(); }
+
+	// The components and their entities, in the same (unspecified) order.
+	std::vector<T>& components() { return m_components; }
+	const std::vector<T>& components() const { return m_components; }
+	const std::vector<Entity>& entities() const { return m_entities; }
+};
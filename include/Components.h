@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/ext.hpp>
+#include "Animator.h"
+#include "Bounds.h"
+#include "Mesh3D.h"
+
+/**
+ * @brief How an object moves, which decides what the world spends on it each frame.
+ */
+enum class Motion : uint8_t {
+	// Never moves once placed. Has no physics body, and its bounds in the world are baked.
+	Static,
+	// Moved only by code or animations, never simulated. Has no physics body.
+	Kinematic,
+	// Simulated by tickPhysics. Every node has a physics body.
+	Dynamic,
+};
+
+/**
+ * @brief What a node draws: its meshes, shared with every clone of the object, and the bounds
+ * the culler tests.
+ */
+struct Renderable {
+	std::vector<std::shared_ptr<const Mesh3D>> meshes;
+	// Some objects from Assimp imports have a "name" field, useful for debugging.
+	std::string name;
+	glm::vec4 material = glm::vec4(0.1, 1.0, 0.3, 4);
+	// Bounds of the node's meshes and all of its descendants, in the node's mesh space
+	// (before its local matrix).
+	Aabb bounds;
+};
+
+/**
+ * @brief A node's Newtonian physics state, advanced by tickPhysics. The world keeps every body's
+ * state in PhysicsBodies, split into columns; this is one body's worth, for creating and copying.
+ */
+struct PhysicsBody {
+	inline static const glm::vec3 GRAVITATIONAL_ACCELERATION = glm::vec3(0, -48, 0);
+	static constexpr float MU = 2;
+
+	glm::vec3 velocity = glm::vec3(0);
+	glm::vec3 acceleration = glm::vec3(0);
+	glm::vec3 rotVelocity = glm::vec3(0);
+	glm::vec3 rotAcceleration = glm::vec3(0);
+	float mass = 1;
+	// The sum of the forces added since the last tick. Starts with gravity, a universal constant.
+	glm::vec3 force = GRAVITATIONAL_ACCELERATION;
+};
+
+/**
+ * @brief Marks the root of a static hierarchy, with the sphere around the whole hierarchy in
+ * world space, computed once when it was made static.
+ */
+struct StaticBounds {
+	BoundingSphere sphere;
+};
+
+/**
+ * @brief Animations playing on an entity. They go away with the entity, so an animator can never
+ * outlive what it animates.
+ */
+struct AnimationTarget {
+	Animator animator;
+};
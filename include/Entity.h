@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Names one object, or one node of an object's hierarchy, in the World. Indices are
+ * reused once an entity is destroyed but generations are not, so a handle kept past its entity's
+ * destruction never silently refers to a newer one; check it with World::isAlive.
+ */
+struct Entity {
+	static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+	uint32_t index = NO_INDEX;
+	uint32_t generation = 0;
+
+	bool isNull() const { return index == NO_INDEX; }
+	bool operator==(const Entity& other) const = default;
+};
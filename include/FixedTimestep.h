@@ -0,0 +1,57 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Turns frames of any length into a whole number of simulation steps of one fixed length,
+ * so the simulation behaves the same at any frame rate. Time that doesn't make up a whole step
+ * is carried over to the next frame, and what fraction of a step it is tells rendering how far
+ * to interpolate from the previous state to the current one.
+ */
+class FixedTimestep {
+private:
+	float m_step;
+	int m_maxSteps;
+	float m_accumulator;
+
+public:
+	/**
+	 * @param rate Steps per second.
+	 * @param maxSteps The most steps one frame may run. A frame that falls further behind than
+	 * that drops the rest of its time, so a slow machine runs the simulation slower rather than
+	 * spending ever longer catching up.
+	 */
+	FixedTimestep(float rate, int maxSteps) : m_step(0), m_maxSteps(maxSteps), m_accumulator(0) {
+		setRate(rate);
+	}
+
+	/**
+	 * @brief Changes the number of steps per second.
+	 * @throws std::invalid_argument if the rate is not positive.
+	 */
+	void setRate(float rate) {
+		if (!(rate > 0)) {
+			throw std::invalid_argument("Simulation rate must be positive");
+		}
+		m_step = 1 / rate;
+	}
+
+	/**
+	 * @brief Adds a frame's time, in seconds, and returns how many steps to run for it.
+	 */
+	int advance(float frameSeconds) {
+		m_accumulator += frameSeconds;
+		int steps = std::min(static_cast<int>(m_accumulator / m_step), m_maxSteps);
+		m_accumulator -= steps * m_step;
+		if (m_accumulator >= m_step) {
+			m_accumulator = std::fmod(m_accumulator, m_step);
+		}
+		return steps;
+	}
+
+	// The length of a step, in seconds.
+	float step() const { return m_step; }
+	// How far the time left over is into the next step, from 0 to 1.
+	float alpha() const { return std::min(m_accumulator / m_step, 1.0f); }
+};
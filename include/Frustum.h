@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/ext.hpp>
+#include "Bounds.h"
+
+/**
+ * @brief Where a bounding volume lies relative to a frustum.
+ */
+enum class Containment : uint8_t {
+	Outside,
+	Intersecting,
+	Inside,
+};
+
+/**
+ * @brief Per-frame culling counts, reported alongside the frame rate.
+ */
+struct CullingStats {
+	// Objects (nodes of an Object3D hierarchy) that were submitted for drawing.
+	size_t visible = 0;
+	// Objects skipped because they, or an ancestor, were outside the view frustum.
+	size_t culled = 0;
+};
+
+/**
+ * @brief The six planes of a camera's view volume, extracted from its projection * view matrix.
+ * Planes point inward and are normalized, so a plane equation gives a signed distance.
+ */
+class Frustum {
+private:
+	// left, right, bottom, top, near, far
+	glm::vec4 m_planes[6];
+
+public:
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/**
+	 * @brief Classifies one sphere.
+	 */
+	Containment classify(const BoundingSphere& sphere) const;
+
+	/**
+	 * @brief Classifies many spheres stored as separate x, y, z and radius arrays, four at a
+	 * time with SSE on x86. Gives the same answers as classify().
+	 */
+	void classify(const float* x, const float* y, const float* z, const float* radius, size_t count,
+		Containment* results) const;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief How many state-changing GL calls went to the driver, and how many were skipped
+ * because the state was already set.
+ */
+struct GLStateStats {
+	size_t issued = 0;
+	size_t elided = 0;
+};
+
+/**
+ * @brief A shadow copy of the GL state the renderer changes: the current program and vertex
+ * array, the buffers bound to the array and uniform targets, the uniform buffer binding points,
+ * the 2D texture bound to each texture unit, and depth testing. Each setter compares against the
+ * shadow copy and only calls GL when the value actually changes, so meshes drawn back to back
+ * with the same vertex array or textures cost no binds.
+ *
+ * The shadow copy is only right if every change to this state goes through here; code that
+ * calls glBindTexture and friends directly must call invalidate() afterwards. Objects must be
+ * deleted through the delete functions, because GL silently unbinds them and a recycled ID would
+ * otherwise look bound already.
+ *
+ * Must only be used on the GL thread.
+ */
+class GLState {
+private:
+	static const uint32_t MAX_TEXTURE_UNITS = 16;
+	static const uint32_t MAX_UNIFORM_BINDINGS = 16;
+
+	uint32_t m_program;
+	uint32_t m_vertexArray;
+	uint32_t m_arrayBuffer;
+	uint32_t m_uniformBuffer;
+	uint32_t m_uniformBindings[MAX_UNIFORM_BINDINGS];
+	uint32_t m_activeTextureUnit;
+	uint32_t m_textures[MAX_TEXTURE_UNITS];
+	bool m_depthTest;
+	bool m_depthMask;
+	uint32_t m_depthFunc;
+	GLStateStats m_stats;
+
+	/**
+	 * @brief Returns whether the call must be issued, and counts it either way.
+	 */
+	bool changes(uint32_t& current, uint32_t value) {
+		if (current == value) {
+			m_stats.elided++;
+			return false;
+		}
+		current = value;
+		m_stats.issued++;
+		return true;
+	}
+
+	uint32_t* bufferSlot(uint32_t target);
+
+public:
+	GLState();
+	GLState(const GLState&) = delete;
+	GLState& operator=(const GLState&) = delete;
+
+	/**
+	 * @brief The state cache for the process's one GL context.
+	 */
+	static GLState& instance();
+
+	/**
+	 * @brief Forgets the shadow copy and assumes GL's initial state, e.g. after a context is
+	 * recreated or after third-party code changed bindings behind the cache's back.
+	 */
+	void invalidate();
+
+	void useProgram(uint32_t program);
+	void bindVertexArray(uint32_t vertexArray);
+
+	/**
+	 * @brief Binds a buffer. Only the array and uniform targets are cached; the element array
+	 * binding belongs to the bound vertex array, and other targets are rare, so those calls
+	 * always go through.
+	 */
+	void bindBuffer(uint32_t target, uint32_t buffer);
+
+	/**
+	 * @brief Binds a buffer to an indexed uniform buffer binding point, which, as in GL, also
+	 * binds it to the generic uniform buffer target.
+	 */
+	void bindBufferBase(uint32_t target, uint32_t index, uint32_t buffer);
+
+	/**
+	 * @brief Binds a 2D texture to a texture unit, selecting the unit first if needed.
+	 */
+	void bindTexture(uint32_t unit, uint32_t texture);
+
+	void setDepthTest(bool enabled);
+	void setDepthMask(bool enabled);
+	void setDepthFunc(uint32_t func);
+
+	void deleteBuffer(uint32_t buffer);
+	void deleteVertexArray(uint32_t vertexArray);
+	void deleteTexture(uint32_t texture);
+
+	/**
+	 * @brief Counts a call cached elsewhere, such as a sampler uniform in ShaderProgram.
+	 */
+	void countCall(bool issued) {
+		if (issued) {
+			m_stats.issued++;
+		}
+		else {
+			m_stats.elided++;
+		}
+	}
+
+	const GLStateStats& stats() const {
+		return m_stats;
+	}
+
+	void resetStats() {
+		m_stats = GLStateStats();
+	}
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief 64-bit FNV-1a hash. Cheap, allocation-free and usable at compile time; good enough for
+ * cache keys and name lookups, but not for anything security related.
+ */
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+constexpr uint64_t fnv1a(std::string_view text, uint64_t hash = FNV_OFFSET_BASIS) {
+	for (char c : text) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
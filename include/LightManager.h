@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/ext.hpp>
+#include "ShaderProgram.h"
+
+// Must match the array sizes in the Lights block of shaders/lighting.frag.
+const uint32_t MAX_POINT_LIGHTS = 20;
+const uint32_t MAX_SPOTLIGHTS = 10;
+
+/**
+ * @brief A directional light, laid out exactly like DirLight in the std140 Lights block.
+ */
+struct DirectionalLight {
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	float padding3;
+};
+
+/**
+ * @brief A point light, laid out exactly like PointLight in the std140 Lights block. Each
+ * vec3 shares its 16 bytes with a float, so there is no hidden padding.
+ */
+struct PointLight {
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	float padding;
+};
+
+/**
+ * @brief A spotlight, laid out exactly like SpotLight in the std140 Lights block.
+ */
+struct SpotLight {
+	glm::vec3 position;
+	float constant;
+	glm::vec3 direction;
+	float linear;
+	glm::vec3 ambient;
+	float quadratic;
+	glm::vec3 diffuse;
+	float cutOff;
+	glm::vec3 specular;
+	float outerCutOff;
+};
+
+static_assert(sizeof(DirectionalLight) == 64 && sizeof(PointLight) == 64 && sizeof(SpotLight) == 80,
+	"light structs must match the std140 Lights block");
+
+/**
+ * @brief Owns the scene's lights and the uniform buffer they live in.
+ * The lights are edited on a CPU copy of the std140 Lights block; each edit widens a dirty
+ * byte range, and upload() sends just that range once per frame. Every program that does
+ * lighting reads the same buffer through uniform block binding LIGHTS_BINDING, so lights are
+ * uploaded once no matter how many programs use them.
+ */
+class LightManager {
+private:
+	/**
+	 * @brief The CPU mirror of the Lights uniform block.
+	 */
+	struct LightBlock {
+		DirectionalLight dirLight;
+		PointLight pointLights[MAX_POINT_LIGHTS];
+		SpotLight spotLights[MAX_SPOTLIGHTS];
+		int32_t numPointLights;
+		int32_t numSpotLights;
+		// std140 rounds the block up to a multiple of 16 bytes.
+		int32_t padding[2];
+	};
+
+	LightBlock m_block;
+	uint32_t m_buffer;
+	// The byte range of m_block changed since the last upload; empty when begin >= end.
+	size_t m_dirtyBegin;
+	size_t m_dirtyEnd;
+
+	void markDirty(const void* field, size_t size);
+
+public:
+	// The uniform buffer binding point the Lights block is bound to.
+	static const uint32_t LIGHTS_BINDING = 0;
+
+	LightManager();
+	~LightManager();
+	LightManager(LightManager&& other) noexcept;
+	LightManager(const LightManager&) = delete;
+	LightManager& operator=(const LightManager&) = delete;
+	LightManager& operator=(LightManager&&) = delete;
+
+	/**
+	 * @brief Points a program's Lights block at this manager's buffer. Programs without the
+	 * block are left alone.
+	 */
+	void attach(ShaderProgram& program) const;
+
+	void setDirectionalLight(const DirectionalLight& light);
+
+	/**
+	 * @brief Sets a point light, extending the number of active point lights to include it.
+	 * @throws std::out_of_range if the index is not below MAX_POINT_LIGHTS.
+	 */
+	void setPointLight(uint32_t index, const PointLight& light);
+
+	/**
+	 * @brief Sets a spotlight, extending the number of active spotlights to include it.
+	 * @throws std::out_of_range if the index is not below MAX_SPOTLIGHTS.
+	 */
+	void setSpotLight(uint32_t index, const SpotLight& light);
+
+	/**
+	 * @brief Moves and aims an existing spotlight; only those 28 bytes are uploaded.
+	 * @throws std::out_of_range if the index is not below MAX_SPOTLIGHTS.
+	 */
+	void moveSpotLight(uint32_t index, const glm::vec3& position, const glm::vec3& direction);
+
+	/**
+	 * @brief Recolors an existing spotlight, e.g. to switch it off with black.
+	 * @throws std::out_of_range if the index is not below MAX_SPOTLIGHTS.
+	 */
+	void setSpotLightColor(uint32_t index, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular);
+
+	/**
+	 * @throws std::out_of_range if the index is not below MAX_SPOTLIGHTS.
+	 */
+	const SpotLight& getSpotLight(uint32_t index) const;
+
+	/**
+	 * @brief Sends the dirty range to the GPU, if any. Call once per frame before drawing.
+	 */
+	void upload();
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+/**
+ * @brief A read-only memory mapping of an entire file. The mapping stays valid until the
+ * MappedFile is destroyed, so pointers into data() must not outlive it.
+ */
+class MappedFile {
+private:
+	const std::byte* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_fd;
+#endif
+
+	void close();
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Maps the given file into memory. Returns false if the file does not exist, is empty,
+	 * or cannot be mapped.
+	 */
+	bool open(const std::filesystem::path& path);
+
+	const std::byte* data() const;
+	size_t size() const;
+};
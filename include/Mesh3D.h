@@ -1,8 +1,10 @@
 #pragma once
 #include <glm/ext.hpp>
 #include <glad/glad.h>
+#include <span>
 #include <vector>
 
+#include "Bounds.h"
 #include "Texture.h"
 #include "ShaderProgram.h"
 struct Vertex3D {
@@ -22,15 +24,29 @@ struct Vertex3D {
 		x(px), y(py), z(pz), nx(normX), ny(normY), nz(normZ), u(texU), v(texV) {}
 };
 
+/**
+ * @brief A mesh uploaded to the GPU. Move-only: it owns its vertex array and buffers and deletes
+ * them when destroyed. Objects placed from the same model share meshes through shared_ptr.
+ */
 class Mesh3D {
 private:
 	uint32_t m_vao;
-	std::vector<Texture> m_textures;
+	uint32_t m_vbo;
+	uint32_t m_ebo;
+	std::vector<TextureBinding> m_textures;
 	uint32_t m_vertexCount;
 	uint32_t m_faceCount;
+	// Local-space bounds of the vertices, computed once at construction.
+	Aabb m_bounds;
+	BoundingSphere m_sphere;
 
 public:
 	Mesh3D() = delete;
+	~Mesh3D();
+	Mesh3D(Mesh3D&& other) noexcept;
+	Mesh3D& operator=(Mesh3D&& other) noexcept;
+	Mesh3D(const Mesh3D&) = delete;
+	Mesh3D& operator=(const Mesh3D&) = delete;
 
 	
 	/**
@@ -39,18 +55,40 @@ public:
 	Mesh3D(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& faces);
 
 	Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
-		Texture texture);
+		TextureBinding texture);
 
 	Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
-		std::vector<Texture>&& textures);
+		std::vector<TextureBinding>&& textures);
 
-	void addTexture(Texture texture);
+	/**
+	 * @brief Constructs a Mesh3D by uploading vertices and faces from memory the mesh does not own,
+	 * such as a memory-mapped mesh cache. The memory is only read during construction.
+	*/
+	Mesh3D(std::span<const Vertex3D> vertices, std::span<const uint32_t> faces,
+		std::vector<TextureBinding>&& textures);
+
+	void addTexture(TextureBinding texture);
 
 	/**
 	 * @brief Constructs a 1x1 square centered at the origin in world space.
 	*/
-	static Mesh3D square(const std::vector<Texture>& textures);
+	static Mesh3D square(const std::vector<TextureBinding>& textures);
 	
+	/**
+	 * @brief The vertex array object holding the mesh's buffers.
+	*/
+	uint32_t getVao() const;
+	uint32_t getFaceCount() const;
+	const Aabb& getBounds() const;
+	const BoundingSphere& getBoundingSphere() const;
+	const std::vector<TextureBinding>& getTextures() const;
+
+	/**
+	 * @brief Binds each of the mesh's textures to the texture unit for its role (see
+	 * textureUnitFor) and points its sampler there, without drawing anything.
+	*/
+	void bindTextures(ShaderProgram& program) const;
+
 	/**
 	 * @brief Renders the mesh to the given context.
 	 * @param model the local->world model transformation matrix.
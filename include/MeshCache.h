@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include "ModelData.h"
+
+/**
+ * @brief A versioned binary cache of post-processed Assimp imports, so that warm starts can
+ * skip Assimp entirely. Each model gets one file under cache/meshes, keyed by its source path,
+ * the source file's modification time, and the Assimp import flags.
+ *
+ * The file is laid out so that vertex and index arrays can be used in place from a memory
+ * mapping: every array starts on a 4-byte boundary and is stored in Vertex3D/uint32_t layout.
+ */
+
+// Bump this whenever the file layout, Vertex3D, or which textures a mesh records changes.
+const uint32_t MESH_CACHE_VERSION = 2;
+
+/**
+ * @brief The cache file that would hold the given model imported with the given flags.
+ */
+std::filesystem::path meshCachePath(const std::filesystem::path& modelPath, uint32_t importFlags);
+
+/**
+ * @brief Maps the cache file for the given model, if one exists and is still valid for the
+ * source file and import flags. On success, model's mesh spans point into the mapping.
+ */
+bool loadMeshCache(const std::filesystem::path& modelPath, uint32_t importFlags, ModelData& model);
+
+/**
+ * @brief Writes the given imported model to its cache file. Failure to write is reported but
+ * not fatal; the next launch will simply import the model again.
+ */
+void storeMeshCache(const std::filesystem::path& modelPath, uint32_t importFlags, const ModelData& model);
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Builds mip chains on the CPU with a 2x2 box filter, so every level can be uploaded
+ * explicitly instead of running glGenerateMipmap on the GL thread.
+ *
+ * Each output channel is (a + b + c + d + 2) >> 2 of the 2x2 block below it. A dimension that
+ * is already 1 is left alone, and an odd dimension drops its last row or column. The SSE2 and
+ * AVX2 kernels compute exactly the same integer result as the scalar one, so cooked textures
+ * do not depend on which CPU cooked them.
+ */
+
+/**
+ * @brief An 8-bit image with 1-4 interleaved channels that may or may not own its pixels.
+ */
+struct MipImage {
+	int32_t width = 0;
+	int32_t height = 0;
+	int32_t channels = 0;
+	const uint8_t* pixels = nullptr;
+	std::vector<uint8_t> storage;
+};
+
+/**
+ * @brief Which downsampling kernel to run.
+ */
+enum class MipKernel {
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+/**
+ * @brief The fastest kernel this CPU supports, detected once.
+ */
+MipKernel bestMipKernel();
+
+/**
+ * @brief Halves one mip level. 1, 2 and 4 channel images use the requested SIMD kernel (falling
+ * back to the best one the CPU actually supports); 3 channel images and the leftover pixels at
+ * the end of each row always use the scalar kernel.
+ */
+MipImage downsampleMip(const MipImage& source, MipKernel kernel = bestMipKernel());
+
+/**
+ * @brief Every level below the given one, down to 1x1, in order. The source is not copied.
+ */
+std::vector<MipImage> generateMipChain(const MipImage& source, MipKernel kernel = bestMipKernel());
@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm/ext.hpp>
+#include "Mesh3D.h"
+#include "MappedFile.h"
+
+/**
+ * @brief A texture used by a mesh, as named by the model's material. The path is relative to
+ * the directory containing the model file.
+ */
+struct TextureReference {
+	std::string path;
+	std::string samplerName;
+};
+
+/**
+ * @brief The CPU-side geometry of one mesh of an imported model, ready to be uploaded.
+ * The vertex and face spans point either into the owned vectors below (after an Assimp import)
+ * or directly into a memory-mapped mesh cache file.
+ */
+struct MeshData {
+	MeshData() = default;
+	// Copying would leave the copy's spans pointing at the original's vectors.
+	MeshData(const MeshData&) = delete;
+	MeshData& operator=(const MeshData&) = delete;
+	MeshData(MeshData&&) = default;
+	MeshData& operator=(MeshData&&) = default;
+
+	std::span<const Vertex3D> vertices;
+	std::span<const uint32_t> faces;
+	std::vector<TextureReference> textures;
+
+	std::vector<Vertex3D> ownedVertices;
+	std::vector<uint32_t> ownedFaces;
+};
+
+/**
+ * @brief One node of an imported model's hierarchy.
+ */
+struct NodeData {
+	std::string name;
+	glm::mat4 baseTransform;
+	// Index of the parent node, or -1 for the root. Parents always precede their children.
+	int32_t parent;
+	// Indices into ModelData::meshes.
+	std::vector<uint32_t> meshes;
+};
+
+/**
+ * @brief Everything needed to construct an Object3D hierarchy for a model, without touching
+ * OpenGL. Produced either by Assimp or by reading a mesh cache file.
+ */
+struct ModelData {
+	std::vector<MeshData> meshes;
+	std::vector<NodeData> nodes;
+	// Keeps a mapped cache file alive while meshes still reference it.
+	std::shared_ptr<MappedFile> mapping;
+};
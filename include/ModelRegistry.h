@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Object3D.h"
+
+class AssetLoader;
+
+/**
+ * @brief Caches imported models by file path, so that each model file is parsed and uploaded
+ * to the GPU only once no matter how many times it is placed in a scene.
+ * Instances share the prototype's vertex arrays and textures; only their transforms and
+ * physics state are unique.
+ *
+ * Models can be requested ahead of time, in which case they are imported and their textures
+ * decoded on the shared ThreadPool while the caller keeps building the scene.
+ */
+class ModelRegistry {
+private:
+	// The parsed model for each (path, flip) combination, keyed by makeKey().
+	std::unordered_map<std::string, Object3D> m_prototypes;
+	// Background loading pipeline for requested models.
+	std::unique_ptr<AssetLoader> m_loader;
+
+	static std::string makeKey(const std::string& path, bool flipTextureCoords);
+
+	void addPrototype(const std::string& key, Object3D&& object);
+
+public:
+	ModelRegistry();
+	~ModelRegistry();
+	ModelRegistry(ModelRegistry&&) noexcept;
+	ModelRegistry& operator=(ModelRegistry&&) noexcept;
+
+	/**
+	 * @brief Starts importing the given model on worker threads, if it has not been already.
+	 */
+	void request(const std::string& path, bool flipTextureCoords);
+
+	/**
+	 * @brief Uploads every requested model, blocking until all of them have been imported.
+	 */
+	void finishLoading();
+
+	/**
+	 * @brief Returns the shared prototype for the given model file, importing it with Assimp
+	 * the first time it is requested.
+	 */
+	const Object3D& prototype(const std::string& path, bool flipTextureCoords);
+
+	/**
+	 * @brief Returns a new Object3D referencing the same meshes and textures as the prototype
+	 * of the given model file. The new object is dynamic.
+	 */
+	Object3D instantiate(const std::string& path, bool flipTextureCoords);
+
+	/**
+	 * @brief The number of distinct models that have been imported.
+	 */
+	size_t size() const;
+};
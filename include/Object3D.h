@@ -2,40 +2,37 @@
 #include <memory>
 #include "ShaderProgram.h"
 #include "Mesh3D.h"
+#include "Frustum.h"
+#include "World.h"
+class RenderQueue;
+
+/**
+ * @brief An object in the scene: the root entity of a hierarchy in the World, each node with its
+ * own transform, renderable and physics body. The object owns the hierarchy and destroys it
+ * when it goes away; in between, anything else should refer to it by entity, which stays valid
+ * however the object is moved around. Move-only, so building a scene never copies a hierarchy by
+ * accident. The meshes are shared with every clone(), such as all the objects a ModelRegistry
+ * places from one model.
+ *
+ * A new object is dynamic. Scenery should be made static once it is placed, and anything moved
+ * only by code or animations kinematic, so that physics never visits them; see Motion.
+ */
 class Object3D {
 private:
-	// The object's list of meshes and children.
-	std::vector<Mesh3D> m_meshes;
-	std::vector<Object3D> m_children;
+	Entity m_root;
 
-	// The object's position, orientation, and scale in world space.
-	glm::vec3 m_position;
-	glm::vec3 m_orientation;
-	glm::vec3 m_scale;
-	glm::vec3 m_center;
+	explicit Object3D(Entity root);
 
-	// Newtonian physics components
-	const glm::vec3 GRAVITATIONAL_ACCELERATION = glm::vec3(0, -48, 0);
-	const float MU = 2;
-	glm::vec3 m_velocity;
-	glm::vec3 m_acceleration;
-	glm::vec3 m_rot_velocity;
-	glm::vec3 m_rot_acceleration;
-	float m_mass;
-	std::vector<glm::vec3> m_forces;
-
-
-	// The object's material.
-	glm::vec4 m_material;
-
-	// The object's base transformation matrix.
-	glm::mat4 m_baseTransform;
-
-	// Some objects from Assimp imports have a "name" field, useful for debugging.
-	std::string m_name;
-
-	// Recomputes the local->world transformation matrix.
-	glm::mat4 buildModelMatrix() const;
+	size_t firstSlot() const;
+	// The root's slot, for changing its transform. Throws std::logic_error if the object is static.
+	size_t movableSlot() const;
+	void bakeStaticBounds();
+	Renderable& renderable() const;
+	PhysicsBody body() const;
+	// A node's bounds in its parent's mesh space, valid for any orientation.
+	Aabb boundsInParent(Entity node) const;
+	void submitContained(RenderQueue& queue, Containment containment, const Frustum& frustum,
+		CullingStats& stats) const;
 
 
 public:
@@ -43,31 +40,69 @@ public:
 	Object3D() = delete;
 
 	Object3D(std::vector<Mesh3D>&& meshes);
-	Object3D(std::vector<Mesh3D>&& meshes, const glm::mat4& baseTransform);
-
-	// Simple accessors.
+	Object3D(std::vector<std::shared_ptr<const Mesh3D>>&& meshes, const glm::mat4& baseTransform);
+	Object3D(Object3D&& other) noexcept;
+	Object3D& operator=(Object3D&& other) noexcept;
+	Object3D(const Object3D&) = delete;
+	Object3D& operator=(const Object3D&) = delete;
+	~Object3D();
+
+	/**
+	 * @brief A copy of the object and its children, with the same transforms and physics state
+	 * but sharing their meshes rather than uploading them again.
+	 */
+	Object3D clone() const;
+
+	// Simple accessors, for the root node. References are good until entities are next added
+	// to or removed from the World. The physics state exists only for dynamic objects; the
+	// accessors throw std::out_of_range for others.
 	const glm::vec3& getPosition() const;
-	const glm::vec3& getOrientation() const;
+	// Euler angles, applied about Z, then X, then Y; see orientationFromEuler.
+	glm::vec3 getOrientation() const;
+	const glm::quat& getRotation() const;
 	const glm::vec3& getScale() const;
 	const glm::vec3& getCenter() const;
 	const std::string& getName() const;
 	const glm::vec4& getMaterial() const;
-	const glm::vec3& getVelocity() const;
-	const glm::vec3& getAcceleration() const;
-	const glm::vec3& getRotationalVelocity() const;
-	const glm::vec3& getRotationalAcceleration() const;
-	const float& getMass() const;
-	const std::vector<glm::vec3>& getForces() const;
-
-	// Child management.
+	glm::vec3 getVelocity() const;
+	glm::vec3 getAcceleration() const;
+	glm::vec3 getRotationalVelocity() const;
+	glm::vec3 getRotationalAcceleration() const;
+	float getMass() const;
+	// The sum of the forces added since the last tick, gravity included.
+	glm::vec3 getForce() const;
+
+	// Bounds of the whole hierarchy in mesh space. Kept up to date by addChild; call
+	// updateBounds after moving or scaling a child (orientation changes need no update).
+	const Aabb& getBounds() const;
+	void updateBounds();
+
+	Motion getMotion() const;
+	/**
+	 * @brief Gives every node in the hierarchy a physics body if the object becomes dynamic, and
+	 * removes them otherwise. Making the object static bakes its bounds in the world, after which
+	 * it can no longer be moved, nor have children added, until it is made kinematic or dynamic
+	 * again; it must not be animated either.
+	 */
+	void setMotion(Motion motion);
+
+	bool isCollidable() const;
+	/**
+	 * @brief Adds the object to collision detection, with a box around its whole hierarchy, or
+	 * takes it out. Objects don't collide unless asked to.
+	 */
+	void setCollidable(bool collidable);
+
+	// Entities, for animating the object or one of its root's children.
+	Entity getEntity() const;
 	size_t numberOfChildren() const;
-	const Object3D& getChild(size_t index) const;
-	Object3D& getChild(size_t index);
+	Entity getChild(size_t index) const;
 
 
-	// Simple mutators.
+	// Simple mutators. Those of the transform throw std::logic_error if the object is static.
 	void setPosition(const glm::vec3& position);
 	void setOrientation(const glm::vec3& orientation);
+	void setRotation(const glm::quat& rotation);
 	void setScale(const glm::vec3& scale);
 	void setCenter(const glm::vec3& center);
 	void setName(const std::string& name);
@@ -80,14 +115,20 @@ public:
 	void addForce(const glm::vec3& force);
 	void clearForces();
 
-	// Transformations.
+	// Transformations. Physics is advanced for every object at once by tickPhysics.
 	void move(const glm::vec3& offset);
+	// Turns the object in its own frame. Turning about one axis at a time adds to that Euler angle.
 	void rotate(const glm::vec3& rotation);
+	void rotate(const glm::quat& rotation);
 	void grow(const glm::vec3& growth);
 	void addChild(Object3D&& child);
-	void tick(float dt);
 
-	// Rendering.
+	// Rendering. Both use the world matrices from the last TransformStore::updateWorld().
 	void render(ShaderProgram& shaderProgram) const;
-	void renderRecursive(ShaderProgram& shaderProgram, const glm::mat4& parentMatrix) const;
-};
\ No newline at end of file
+	// Queues the object's meshes for instanced drawing instead of drawing them right away.
+	void submit(RenderQueue& queue) const;
+	// Queues only the parts of the objects that can be inside the frustum. Whole hierarchies
+	// outside it are skipped without looking at any of their nodes.
+	static void submitVisible(const std::vector<Object3D>& objects, RenderQueue& queue,
+		const Frustum& frustum, CullingStats& stats);
+};
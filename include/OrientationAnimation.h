@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include "World.h"
+#include "Animation.h"
+/**
+ * @brief Turns an object from wherever it faces when the animation starts to a target
+ * orientation, at a constant angular speed along the shortest arc.
+ */
+class OrientationAnimation : public Animation {
+private:
+	/**
+	 * @brief The orientation when the animation started, and the one it ends at.
+	 */
+	glm::quat m_start;
+	glm::quat m_target;
+
+	void startAnimation() override {
+		auto& world = World::instance();
+		if (world.isAlive(node())) {
+			m_start = world.transforms.orientationAt(world.transforms.slotOf(node()));
+		}
+	}
+
+	/**
+	 * @brief Advance the animation by the given time interval.
+	 */
+	void applyAnimation(float dt) override {
+		auto& world = World::instance();
+		if (!world.isAlive(node())) {
+			return;
+		}
+		auto& transforms = world.transforms;
+		float t = std::min(currentTime() / duration(), 1.0f);
+		transforms.setOrientationAt(transforms.slotOf(node()), glm::normalize(glm::slerp(m_start, m_target, t)));
+	}
+
+public:
+	/**
+	 * @brief Constructs an animation that turns to the given orientation across the given duration.
+	 */
+	OrientationAnimation(Entity node, float duration, const glm::quat& target) :
+		Animation(node, duration), m_start(1, 0, 0, 0), m_target(target) {}
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "PhysicsBodies.h"
+#include "World.h"
+
+/**
+ * @brief Which integration kernel to run.
+ */
+enum class PhysicsKernel {
+	Scalar,
+	AVX,
+};
+
+/**
+ * @brief The fastest kernel this CPU supports, detected once.
+ */
+PhysicsKernel bestPhysicsKernel();
+
+/**
+ * @brief Advances every body by the given interval, in seconds, working on the columns alone.
+ * A body resting on the ground (y exactly 0) feels friction against its horizontal velocity
+ * and the ground's normal force, unless it has stopped along x, which also cancels every other
+ * force on it. Each body's acceleration becomes its net force over its mass (massless bodies
+ * keep theirs), its forces are cleared back to gravity, and it moves; nothing ends up below the
+ * ground. The AVX kernel does eight bodies at a time and gives exactly the scalar kernel's
+ * results, falling back to it on CPUs without AVX.
+ */
+void integrateBodies(PhysicsBodies& bodies, float dt, PhysicsKernel kernel = bestPhysicsKernel());
+
+/**
+ * @brief Advances every physics body in the world by the given interval, in seconds. Each body
+ * moves its node relative to the node's parent.
+ */
+void tickPhysics(World& world, float dt);
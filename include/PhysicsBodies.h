@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/ext.hpp>
+#include "Components.h"
+#include "Entity.h"
+
+/**
+ * @brief Raw pointers to the columns of PhysicsBodies that the integrator works on, each with
+ * one float per body.
+ */
+struct BodyColumns {
+	float* positionX;
+	float* positionY;
+	float* positionZ;
+	float* velocityX;
+	float* velocityY;
+	float* velocityZ;
+	float* accelerationX;
+	float* accelerationY;
+	float* accelerationZ;
+	float* forceX;
+	float* forceY;
+	float* forceZ;
+	const float* mass;
+	size_t count;
+};
+
+/**
+ * @brief The physics body of every dynamic entity, stored as a sparse set like ComponentArray
+ * but with the state split into one contiguous array per scalar: positions, velocities,
+ * accelerations and accumulated forces by axis, and masses. The integrator streams each array
+ * eight bodies at a time, and adding a force is three additions with no allocation.
+ *
+ * The positions are a working copy: tickPhysics fills them from the TransformStore before
+ * integrating, and writes them back after.
+ */
+class PhysicsBodies {
+private:
+	static constexpr uint32_t ABSENT = UINT32_MAX;
+
+	// Dense position of each entity index's body, or ABSENT.
+	std::vector<uint32_t> m_sparse;
+	std::vector<Entity> m_entities;
+	std::vector<float> m_positionX, m_positionY, m_positionZ;
+	std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+	std::vector<float> m_accelerationX, m_accelerationY, m_accelerationZ;
+	std::vector<float> m_forceX, m_forceY, m_forceZ;
+	std::vector<float> m_mass;
+	// Not integrated, so kept whole.
+	std::vector<glm::vec3> m_rotVelocities;
+	std::vector<glm::vec3> m_rotAccelerations;
+
+	/**
+	 * @brief Calls the function with each of the per-body arrays.
+	 */
+	template <typename Function>
+	void forEachColumn(Function function) {
+		function(m_entities);
+		function(m_positionX);
+		function(m_positionY);
+		function(m_positionZ);
+		function(m_velocityX);
+		function(m_velocityY);
+		function(m_velocityZ);
+		function(m_accelerationX);
+		function(m_accelerationY);
+		function(m_accelerationZ);
+		function(m_forceX);
+		function(m_forceY);
+		function(m_forceZ);
+		function(m_mass);
+		function(m_rotVelocities);
+		function(m_rotAccelerations);
+	}
+
+	uint32_t positionOf(Entity entity) const;
+	// The entity's dense position; throws std::out_of_range if it has no body.
+	size_t at(Entity entity) const;
+
+public:
+	/**
+	 * @brief Gives the entity the body, replacing any it already had.
+	 */
+	void insert(Entity entity, const PhysicsBody& body = PhysicsBody());
+
+	/**
+	 * @brief Removes the entity's body, if it has one. The last body takes its place.
+	 */
+	void remove(Entity entity);
+
+	bool contains(Entity entity) const {
+		return positionOf(entity) != ABSENT;
+	}
+
+	/**
+	 * @brief A copy of the entity's body.
+	 * @throws std::out_of_range if it has none.
+	 */
+	PhysicsBody get(Entity entity) const;
+
+	// Setters for one field of the entity's body. They throw std::out_of_range if it has none.
+	void setVelocity(Entity entity, const glm::vec3& velocity);
+	void setAcceleration(Entity entity, const glm::vec3& acceleration);
+	void setRotationalVelocity(Entity entity, const glm::vec3& rotVelocity);
+	void setRotationalAcceleration(Entity entity, const glm::vec3& rotAcceleration);
+	// Changes the mass, and with it the weight: every force but gravity is cleared.
+	void setMass(Entity entity, float mass);
+	void addForce(Entity entity, const glm::vec3& force);
+	// Removes every force but gravity.
+	void clearForces(Entity entity);
+
+	size_t size() const { return m_entities.size(); }
+	const std::vector<Entity>& entities() const { return m_entities; }
+
+	glm::vec3 positionAt(size_t i) const {
+		return glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+	}
+	void setPositionAt(size_t i, const glm::vec3& position) {
+		m_positionX[i] = position.x;
+		m_positionY[i] = position.y;
+		m_positionZ[i] = position.z;
+	}
+
+	BodyColumns columns();
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/ext.hpp>
+#include "Mesh3D.h"
+#include "ShaderProgram.h"
+
+/**
+ * @brief Draws a frame's meshes in three phases: extract, sort, submit.
+ * Extract: objects are flattened into draw items as they are submitted (see Object3D::submit),
+ * each with its model and normal matrices and a 64-bit sort key. Sort: render() radix-sorts the
+ * keys. Submit: runs of items with the same program, textures and vertex array become one
+ * glDrawElementsInstanced, with every state change going through GLState.
+ *
+ * The key orders by program, then texture set, then vertex array, so state changes are as few as
+ * possible, and last by distance from the viewer, so each batch's instances are drawn front to
+ * back and the depth test rejects more hidden fragments before shading them. Batches read the
+ * model and normal matrices as per-instance attributes, as in
+ * shaders/light_perspective_instanced.vert.
+ */
+class RenderQueue {
+private:
+	/**
+	 * @brief The per-instance vertex attributes, in the order the instanced shader reads them.
+	 */
+	struct InstanceData {
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+	};
+
+	/**
+	 * @brief One mesh to draw once. Items are only ever moved by sorting their keys.
+	 */
+	struct DrawItem {
+		const Mesh3D* mesh;
+		uint32_t program;
+		uint32_t material;
+	};
+
+	struct SortEntry {
+		uint64_t key;
+		uint32_t item;
+	};
+
+	// Key layout, from the most significant bit down.
+	static const uint32_t PROGRAM_BITS = 8;
+	static const uint32_t MATERIAL_BITS = 20;
+	static const uint32_t VERTEX_ARRAY_BITS = 16;
+	static const uint32_t DEPTH_BITS = 20;
+
+	uint32_t m_instanceBuffer;
+	// How many instances the buffer has room for.
+	size_t m_capacity;
+
+	// Programs drawn with, in the order they were first used; an item's program is its index.
+	std::vector<ShaderProgram*> m_programs;
+	uint32_t m_currentProgram;
+	// Texture sets by hash, numbered as they are first seen. Kept across frames so keys are stable.
+	std::unordered_map<uint64_t, uint32_t> m_materials;
+
+	glm::vec3 m_viewer;
+	float m_maxDistance;
+
+	std::vector<DrawItem> m_items;
+	std::vector<InstanceData> m_instances;
+	std::vector<SortEntry> m_keys;
+	std::vector<SortEntry> m_sortScratch;
+	std::vector<InstanceData> m_staging;
+
+	uint32_t materialOf(const Mesh3D& mesh);
+
+	/**
+	 * @brief Sorts entries by key, least significant byte first, skipping bytes every key shares.
+	 * Stable, so equal keys keep the order they were added in.
+	 */
+	static void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+	void bindInstanceAttributes(size_t firstInstance) const;
+
+public:
+	// The first attribute location used by the per-instance data: 4 for the model matrix's
+	// columns, then 3 for the normal matrix's.
+	static const uint32_t FIRST_INSTANCE_ATTRIBUTE = 4;
+
+	RenderQueue();
+	~RenderQueue();
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	/**
+	 * @brief Sets the program that meshes added from now on are drawn with. The program must
+	 * stay alive until render(). At most 256 distinct programs may be used.
+	 */
+	void setProgram(ShaderProgram& program);
+
+	/**
+	 * @brief Sets where distances are measured from for front-to-back ordering; meshes further
+	 * than maxDistance sort as if they were at it.
+	 */
+	void setViewer(const glm::vec3& position, float maxDistance);
+
+	/**
+	 * @brief Queues one instance of a mesh with the given local->world matrix. The mesh must
+	 * stay alive until render().
+	 */
+	void add(const Mesh3D& mesh, const glm::mat4& model);
+
+	/**
+	 * @brief Sorts and draws everything queued since the last call, and clears the queue.
+	 * Returns the number of draw calls issued.
+	 */
+	size_t render();
+};
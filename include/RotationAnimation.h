@@ -1,5 +1,6 @@
 #pragma once
-#include "Object3D.h"
+#include "World.h"
+#include "TransformKernel.h"
 #include "Animation.h"
 /**
  * @brief Rotates an object at a continuous rate over an interval.
@@ -7,7 +8,7 @@
 class RotationAnimation : public Animation {
 private:
 	/**
-	 * @brief How much to increment the orientation by each second.
+	 * @brief How much to turn by each second, as Euler angles in the object's own frame.
 	 */
 	glm::vec3 m_perSecond;
 
@@ -15,7 +16,13 @@ private:
 	 * @brief Advance the animation by the given time interval.
 	 */
 	void applyAnimation(float dt) override {
-		object().rotate(m_perSecond * dt);
+		auto& world = World::instance();
+		if (!world.isAlive(node())) {
+			return;
+		}
+		auto& transforms = world.transforms;
+		auto slot = transforms.slotOf(node());
+		transforms.setOrientationAt(slot, glm::normalize(transforms.orientationAt(slot) * orientationFromEuler(m_perSecond * dt)));
 	}
 
 public:
@@ -23,7 +30,7 @@ public:
 	 * @brief Constructs a animation of a constant rotation by the given total rotation
 	 * angle, linearly interpolated across the given duration.
 	 */
-	RotationAnimation(Object3D& object, float duration, const glm::vec3& totalRotation) :
-		Animation(object, duration), m_perSecond(totalRotation / duration) {}
+	RotationAnimation(Entity node, float duration, const glm::vec3& totalRotation) :
+		Animation(node, duration), m_perSecond(totalRotation / duration) {}
 };
 
@@ -1,8 +1,89 @@
 #pragma once
 #include <glm/ext.hpp>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include "Hash.h"
+
+/**
+ * @brief Identifies a uniform by the hash of its full name, as glGetActiveUniform reports it
+ * ("material.shininess", "pointLights[2].position"). Names known at compile time are hashed
+ * at compile time, and no form ever allocates.
+ */
+struct UniformName {
+	uint64_t hash;
+
+	constexpr UniformName(const char* name) : hash(fnv1a(std::string_view(name))) {}
+	constexpr UniformName(std::string_view name) : hash(fnv1a(name)) {}
+	UniformName(const std::string& name) : hash(fnv1a(std::string_view(name))) {}
+
+	/**
+	 * @brief The name "array[index]" or "array[index].member", hashed without building it.
+	 */
+	static constexpr UniformName element(std::string_view array, uint32_t index, std::string_view member = {}) {
+		char digits[10] = {};
+		size_t start = sizeof(digits);
+		do {
+			digits[--start] = static_cast<char>('0' + index % 10);
+			index /= 10;
+		} while (index > 0);
+
+		uint64_t hash = fnv1a(array);
+		hash = fnv1a(std::string_view("["), hash);
+		hash = fnv1a(std::string_view(digits + start, sizeof(digits) - start), hash);
+		hash = fnv1a(std::string_view("]"), hash);
+		if (!member.empty()) {
+			hash = fnv1a(std::string_view("."), hash);
+			hash = fnv1a(member, hash);
+		}
+		return UniformName(hash, 0);
+	}
+
+private:
+	constexpr UniformName(uint64_t precomputed, int) : hash(precomputed) {}
+};
+
+/**
+ * @brief A uniform location resolved once, typed by the value it accepts. A handle for a
+ * uniform the program does not use is valid to set, and does nothing, like location -1 in GL.
+ */
+template <typename T>
+struct Uniform {
+	int32_t location = -1;
+
+	bool isActive() const {
+		return location >= 0;
+	}
+};
+
 class ShaderProgram {
+	/**
+	 * @brief One active uniform, as reflected at link time.
+	 */
+	struct UniformInfo {
+		int32_t location;
+		uint32_t type;
+		// The texture unit last given to a sampler uniform; GL starts them all at 0.
+		int32_t samplerUnit = 0;
+	};
+
 	uint32_t m_programId;
+	// Every active uniform outside a uniform block, by UniformName hash.
+	std::unordered_map<uint64_t, UniformInfo> m_uniforms;
+
+	void reflectUniforms();
+
+	static void upload(int32_t location, bool value);
+	static void upload(int32_t location, int32_t value);
+	static void upload(int32_t location, float value);
+	static void upload(int32_t location, const glm::vec2& value);
+	static void upload(int32_t location, const glm::vec3& value);
+	static void upload(int32_t location, const glm::vec4& value);
+	static void upload(int32_t location, const glm::mat2& value);
+	static void upload(int32_t location, const glm::mat3& value);
+	static void upload(int32_t location, const glm::mat4& value);
 
 public:
 	ShaderProgram();
@@ -10,13 +91,44 @@ public:
 
 	void activate();
 
-	void setUniform(const std::string& uniformName, bool value);
-	void setUniform(const std::string& uniformName, int32_t value);
-	void setUniform(const std::string& uniformName, float value);
-	void setUniform(const std::string& uniformName, const glm::vec2& value);
-	void setUniform(const std::string& uniformName, const glm::vec3& value);
-	void setUniform(const std::string& uniformName, const glm::vec4& value);
-	void setUniform(const std::string& uniformName, const glm::mat2& value);
-	void setUniform(const std::string& uniformName, const glm::mat3& value);
-	void setUniform(const std::string& uniformName, const glm::mat4& value);
-};
\ No newline at end of file
+	/**
+	 * @brief Connects the program's uniform block with the given name to a uniform buffer
+	 * binding point. Returns false if the program has no such block.
+	 */
+	bool bindUniformBlock(const char* blockName, uint32_t bindingPoint);
+
+	/**
+	 * @brief The location of an active uniform, or -1 if the program has no such uniform.
+	 * A hash table lookup; never queries GL.
+	 */
+	int32_t location(UniformName name) const;
+
+	/**
+	 * @brief Resolves a typed handle, to keep and set repeatedly without any lookup.
+	 */
+	template <typename T>
+	Uniform<T> uniform(UniformName name) const {
+		return Uniform<T>{ location(name) };
+	}
+
+	template <typename T>
+	void setUniform(Uniform<T> uniform, const std::type_identity_t<T>& value) {
+		upload(uniform.location, value);
+	}
+
+	/**
+	 * @brief Points a sampler uniform at a texture unit, skipping the call if it already is.
+	 * The program must be active.
+	 */
+	void setSampler(UniformName samplerName, int32_t unit);
+
+	void setUniform(UniformName uniformName, bool value);
+	void setUniform(UniformName uniformName, int32_t value);
+	void setUniform(UniformName uniformName, float value);
+	void setUniform(UniformName uniformName, const glm::vec2& value);
+	void setUniform(UniformName uniformName, const glm::vec3& value);
+	void setUniform(UniformName uniformName, const glm::vec4& value);
+	void setUniform(UniformName uniformName, const glm::mat2& value);
+	void setUniform(UniformName uniformName, const glm::mat3& value);
+	void setUniform(UniformName uniformName, const glm::mat4& value);
+};
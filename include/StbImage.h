@@ -6,17 +6,26 @@
 #include <string>
 class StbImage
 {
-    int m_width, m_height, m_bpp;
+    int m_width, m_height, m_bpp, m_channels;
     std::unique_ptr<unsigned char[]> m_data = nullptr;
 
 public:
     StbImage();
 
-    void loadFromFile(const std::string& filepath);
+    // Decodes an image file. desiredChannels (1-4) converts the pixels to that many channels;
+    // 0 keeps however many channels the file has.
+    void loadFromFile(const std::string& filepath, int desiredChannels = 0);
+    // Decodes an image file that has already been read into memory. The name is only used in errors.
+    void loadFromMemory(const unsigned char* bytes, size_t size, const std::string& name, int desiredChannels = 0);
+
+    // How many channels an encoded image file has, without decoding it; 0 if it is not an image.
+    static int channelsInFile(const unsigned char* bytes, size_t size);
 
     int getWidth() const;
     int getHeight() const;
     int getBpp() const;
+    // The number of 8-bit channels per pixel in getData().
+    int getChannels() const;
     unsigned char* getData() const;
 };
 
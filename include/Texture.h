@@ -1,35 +1,280 @@
 #pragma once
 #include <glad/glad.h>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <filesystem>
-#include "StbImage.h"
+#include <vector>
+#include "MappedFile.h"
+#include "GLState.h"
+
+// S3TC (BC1/BC3) comes from EXT_texture_compression_s3tc, which is not part of core OpenGL.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+// The sRGB variants of S3TC come from EXT_texture_sRGB.
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+/**
+ * @brief What a texture is used for, which decides how it can be compressed.
+ */
+enum class TextureRole : uint32_t {
+	BaseColor,
+	Specular,
+	Normal,
+	Height,
+};
+
+/**
+ * @brief Maps a fragment shader sampler name to the role of the textures bound to it.
+ */
+inline TextureRole textureRoleFor(const std::string& samplerName) {
+	if (samplerName.find("specular") != std::string::npos) {
+		return TextureRole::Specular;
+	}
+	if (samplerName.find("normal") != std::string::npos) {
+		return TextureRole::Normal;
+	}
+	if (samplerName.find("height") != std::string::npos) {
+		return TextureRole::Height;
+	}
+	return TextureRole::BaseColor;
+}
+
+/**
+ * @brief The texture unit that textures of a role are bound to. Fixed per role, so a program's
+ * sampler uniforms are set once rather than per mesh.
+ */
+inline int32_t textureUnitFor(TextureRole role) {
+	return static_cast<int32_t>(role);
+}
+
+/**
+ * @brief The storage format of a cooked texture.
+ */
+enum class TextureFormat : uint32_t {
+	RGBA8,
+	// 4 bits per pixel RGB; base color without alpha.
+	BC1,
+	// 8 bits per pixel RGBA; base color with alpha.
+	BC3,
+	// 4 bits per pixel, red only; specular and height maps.
+	BC4,
+	// 8 bits per pixel, red and green; tangent-space normal maps (z is reconstructed).
+	BC5,
+	// Uncompressed single channel; specular and height maps.
+	R8,
+	// Uncompressed red and green; normal maps.
+	RG8,
+	// Uncompressed opaque color.
+	RGB8,
+};
 
 /**
- * @brief Represents a texture that has been loaded into VRAM, and is expected to be bound
- * to a sampler2D with a given sampler name in the fragment shader.
+ * @brief Whether the format is block compressed, and if so how many bytes each 4x4 block takes.
  */
-struct Texture {
+inline uint32_t blockBytes(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::BC1:
+	case TextureFormat::BC4:
+		return 8;
+	case TextureFormat::BC3:
+	case TextureFormat::BC5:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief How many bytes each pixel of an uncompressed format takes; 0 for compressed formats.
+ */
+inline uint32_t pixelBytes(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::R8:
+		return 1;
+	case TextureFormat::RG8:
+		return 2;
+	case TextureFormat::RGB8:
+		return 3;
+	case TextureFormat::RGBA8:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief How many bytes one mip level of the given size takes in the given format.
+ */
+inline size_t levelBytes(TextureFormat format, int32_t width, int32_t height) {
+	auto block = blockBytes(format);
+	if (block == 0) {
+		return static_cast<size_t>(width) * height * pixelBytes(format);
+	}
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * block;
+}
+
+/**
+ * @brief One mip level of a TextureLevels, located by its offset into the shared byte storage.
+ */
+struct TextureLevel {
+	int32_t width;
+	int32_t height;
+	size_t offset;
+	size_t size;
+};
+
+/**
+ * @brief A complete mip chain, level 0 first, ready to upload without any further processing.
+ * The bytes live either in ownedData or in a memory-mapped texture cache file.
+ */
+struct TextureLevels {
+	TextureFormat format = TextureFormat::RGBA8;
+	// Whether the color channels are sRGB encoded, which is true of base color maps.
+	bool srgb = false;
+	std::vector<TextureLevel> levels;
+	std::vector<uint8_t> ownedData;
+	std::shared_ptr<MappedFile> mapping;
+
+	const uint8_t* levelData(size_t level) const {
+		auto base = mapping ? reinterpret_cast<const uint8_t*>(mapping->data()) : ownedData.data();
+		return base + levels[level].offset;
+	}
+};
+
+/**
+ * @brief Owns a texture in VRAM. Move-only: the GL texture is deleted, and dropped from
+ * TextureResidency, when its owner is destroyed. Meshes share textures through TextureBinding.
+ */
+class Texture {
+private:
 	// The ID of the texture, to be bound with glBindTexture when drawing a mesh.
-	uint32_t textureId;
-	// The name of the sampler2D uniform in the fragment shader that this texture will bind to.
-	std::string samplerName;
+	uint32_t m_textureId;
+
+public:
+	explicit Texture(uint32_t textureId);
+	~Texture();
+	Texture(Texture&& other) noexcept;
+	Texture& operator=(Texture&& other) noexcept;
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	uint32_t getId() const {
+		return m_textureId;
+	}
 
 	/**
-	 * @brief Loads an SFML Image into VRAM and returns a Texture object identifying it.
+	 * @brief Uploads a prebuilt mip chain into VRAM, one level at a time, and returns a Texture
+	 * object owning it. No mipmaps are generated on the GPU. Levels above firstLevel are
+	 * skipped, so the texture starts out at a lower resolution (see TextureResidency.h).
 	 */
-	static Texture loadImage(const StbImage& texture, const std::string& samplerName) {
+	static Texture loadLevels(const TextureLevels& texture, size_t firstLevel = 0) {
 		uint32_t texId;
 		glGenTextures(1, &texId);
-		glBindTexture(GL_TEXTURE_2D, texId);
+		GLState::instance().bindTexture(0, texId);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture.getWidth(), texture.getHeight(), 0, GL_RGBA,
-			GL_UNSIGNED_BYTE, texture.getData());
-		glGenerateMipmap(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		applySwizzle(texture.format);
+		uploadLevels(texture, firstLevel);
+
+		return Texture(texId);
+	}
+
+	/**
+	 * @brief Replaces every image of the bound texture with the levels of a mip chain from
+	 * firstLevel down, so that firstLevel becomes level 0. The texture keeps its ID, so meshes
+	 * holding it see the new resolution without being told.
+	 */
+	static void uploadLevels(const TextureLevels& texture, size_t firstLevel) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels.size() - firstLevel) - 1);
 
-		return Texture{ texId, samplerName };
+		auto internalFormat = glInternalFormat(texture.format, texture.srgb);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (size_t i = firstLevel; i < texture.levels.size(); i++) {
+			auto& level = texture.levels[i];
+			auto target = static_cast<GLint>(i - firstLevel);
+			if (blockBytes(texture.format) == 0) {
+				glTexImage2D(GL_TEXTURE_2D, target, internalFormat, level.width, level.height, 0,
+					glPixelFormat(texture.format), GL_UNSIGNED_BYTE, texture.levelData(i));
+			}
+			else {
+				glCompressedTexImage2D(GL_TEXTURE_2D, target, internalFormat,
+					level.width, level.height, 0, static_cast<GLsizei>(level.size), texture.levelData(i));
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	}
-};
\ No newline at end of file
+
+	/**
+	 * @brief Single-channel maps are read as .x, or as a grey vec3; spread red over rgb so both
+	 * work. Must be called with the texture bound.
+	 */
+	static void applySwizzle(TextureFormat format) {
+		if (format == TextureFormat::BC4 || format == TextureFormat::R8) {
+			GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+			glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
+	}
+
+	/**
+	 * @brief The OpenGL internal format for a texture format.
+	 */
+	static GLenum glInternalFormat(TextureFormat format, bool srgb) {
+		switch (format) {
+		case TextureFormat::BC1:
+			return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureFormat::BC3:
+			return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case TextureFormat::BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+		case TextureFormat::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		case TextureFormat::R8:
+			return GL_R8;
+		case TextureFormat::RG8:
+			return GL_RG8;
+		case TextureFormat::RGB8:
+			return srgb ? GL_SRGB8 : GL_RGB8;
+		default:
+			return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		}
+	}
+
+	/**
+	 * @brief The pixel transfer format for an uncompressed texture format.
+	 */
+	static GLenum glPixelFormat(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::R8:
+			return GL_RED;
+		case TextureFormat::RG8:
+			return GL_RG;
+		case TextureFormat::RGB8:
+			return GL_RGB;
+		default:
+			return GL_RGBA;
+		}
+	}
+};
+
+/**
+ * @brief A texture as one mesh uses it: bound to the sampler2D with the given name in the
+ * fragment shader. The texture itself is shared by every mesh that uses the same image.
+ */
+struct TextureBinding {
+	std::shared_ptr<const Texture> texture;
+	// The name of the sampler2D uniform in the fragment shader that this texture will bind to.
+	std::string samplerName;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include "StbImage.h"
+#include "Texture.h"
+
+/**
+ * @brief Converts decoded images into upload-ready mip chains, block compressed according to
+ * their role, and caches the result on disk so later launches skip decoding entirely.
+ *
+ * Base color maps become BC1 (or BC3 if any pixel is translucent), specular and height maps
+ * become BC4, and normal maps become BC5. Without compression, each role gets the smallest
+ * uncompressed format that holds the channels it actually uses: R8 for specular and height,
+ * RG8 for normals, and RGB8 or RGBA8 for base color. Base color is always stored as sRGB, so it
+ * is only compressed when the sRGB variants of BC1 and BC3 are available.
+ */
+
+// Bump this whenever the cache layout or any encoder changes.
+const uint32_t TEXTURE_CACHE_VERSION = 3;
+
+/**
+ * @brief What the GL context (and the user) allow the cooker to produce.
+ */
+struct TextureCookOptions {
+	// Use block compression at all; otherwise every texture is cooked uncompressed.
+	bool compress = true;
+	// BC1/BC3 are available (EXT_texture_compression_s3tc).
+	bool allowS3TC = false;
+	// sRGB variants of BC1/BC3 are available (EXT_texture_sRGB).
+	bool allowCompressedSRGB = false;
+};
+
+/**
+ * @brief How many channels to decode an image with the given role into, given how many the
+ * file has. Specular and height maps only need red, and normal maps only red and green.
+ */
+int decodeChannelsFor(TextureRole role, int sourceChannels);
+
+/**
+ * @brief Picks the storage format for a decoded image with the given role.
+ */
+TextureFormat chooseTextureFormat(const StbImage& image, TextureRole role, const TextureCookOptions& options);
+
+/**
+ * @brief Whether a texture with the given role and format is stored with sRGB color.
+ */
+bool cookAsSRGB(TextureRole role, TextureFormat format, const TextureCookOptions& options);
+
+/**
+ * @brief Builds the full mip chain of a decoded image and encodes every level in the given format.
+ */
+TextureLevels cookTexture(const StbImage& image, TextureFormat format, bool srgb);
+
+/**
+ * @brief The cache file for an image with the given content hash, cooked for the given role.
+ */
+std::filesystem::path textureCachePath(uint64_t contentHash, TextureRole role, const TextureCookOptions& options);
+
+/**
+ * @brief Maps a previously cooked texture, if its cache file exists and is valid.
+ */
+bool loadCookedTexture(const std::filesystem::path& cachePath, uint64_t contentHash, TextureLevels& texture);
+
+/**
+ * @brief Writes a cooked texture to its cache file. Failure to write is reported but not fatal.
+ */
+void storeCookedTexture(const std::filesystem::path& cachePath, uint64_t contentHash, const TextureLevels& texture);
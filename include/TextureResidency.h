@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "Texture.h"
+
+/**
+ * @brief Keeps the textures in VRAM within a byte budget.
+ * Every texture uploaded through upload() is accounted for. When the total goes over budget at
+ * the end of a frame, the largest resident mip level of the least-recently-drawn texture is
+ * dropped, repeatedly, until the total fits. Textures drawn while downscaled get their levels
+ * back, one per frame, as long as that still fits. Dropping and restoring re-specify the same
+ * GL texture, so Texture objects held by meshes stay valid.
+ *
+ * The full mip chain of each texture stays available on the CPU side as a memory-mapped
+ * texture cache file (see TextureCooker.h). A texture whose levels are not mapped cannot be
+ * restored cheaply, so it is pinned at full resolution and only counted.
+ *
+ * Must only be used on the GL thread.
+ */
+class TextureResidency {
+private:
+	struct Record {
+		TextureLevels levels;
+		// The mip level currently uploaded as GL level 0.
+		size_t firstLevel = 0;
+		// The highest firstLevel allowed; 0 for pinned textures.
+		size_t lowestFirstLevel = 0;
+		size_t residentBytes = 0;
+		uint64_t lastDrawnFrame = 0;
+	};
+
+	std::unordered_map<uint32_t, Record> m_textures;
+	size_t m_budget;
+	size_t m_residentBytes;
+	// Levels whose larger side is below this are never dropped.
+	int32_t m_minimumSize;
+	// Caps how many bytes restore() uploads in one frame, to avoid hitches.
+	size_t m_restoreBytesPerFrame;
+	uint64_t m_frame;
+
+	static size_t bytesFrom(const TextureLevels& levels, size_t firstLevel);
+	void setFirstLevel(uint32_t textureId, Record& record, size_t firstLevel);
+
+public:
+	TextureResidency();
+	TextureResidency(const TextureResidency&) = delete;
+	TextureResidency& operator=(const TextureResidency&) = delete;
+
+	/**
+	 * @brief The residency manager for every texture in the process.
+	 */
+	static TextureResidency& instance();
+
+	/**
+	 * @brief Sets the VRAM budget for textures, in bytes. Takes effect at the next endFrame().
+	 */
+	void setBudget(size_t bytes);
+
+	/**
+	 * @brief Uploads a mip chain and starts tracking it, skipping its largest levels if the
+	 * budget is already spent. Returns the new texture, which stops being tracked when destroyed.
+	 */
+	Texture upload(TextureLevels&& levels);
+
+	/**
+	 * @brief Marks a texture as drawn this frame. Unknown IDs are ignored.
+	 */
+	void touch(uint32_t textureId) {
+		auto it = m_textures.find(textureId);
+		if (it != m_textures.end()) {
+			it->second.lastDrawnFrame = m_frame;
+		}
+	}
+
+	/**
+	 * @brief Deletes a texture and stops tracking it, if it was tracked. Called by ~Texture.
+	 */
+	void release(uint32_t textureId);
+
+	/**
+	 * @brief Drops levels until the budget is met, then restores levels of textures drawn this
+	 * frame that still fit. Call once per frame, after drawing.
+	 */
+	void endFrame();
+
+	size_t budget() const {
+		return m_budget;
+	}
+
+	size_t residentBytes() const {
+		return m_residentBytes;
+	}
+
+	/**
+	 * @brief How many bytes of VRAM the given texture currently uses; 0 if it is not tracked.
+	 */
+	size_t bytesOf(uint32_t textureId) const;
+};
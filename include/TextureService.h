@@ -0,0 +1,119 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Texture.h"
+#include "TextureCooker.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Process-wide texture loading and deduplication.
+ * Images are identified first by their normalized path and then by a hash of their file
+ * contents, so the same image referenced from different models, scenes, or paths is decoded
+ * and uploaded exactly once per role. Decoding and cooking (see TextureCooker.h) run on the
+ * shared ThreadPool, and cooked mip chains are cached on disk, so a warm start only maps the
+ * cache file. Uploads happen on the GL thread in load() or uploadReady().
+ *
+ * The service does not keep textures alive once they are claimed: once every mesh using a
+ * texture is destroyed, the texture is deleted, and a later load() decodes the image again (from
+ * the cooked cache file). A texture uploadReady() uploads ahead of time is held until load()
+ * first hands it out, or until clear(), which must run before the GL context goes away.
+ */
+class TextureService {
+private:
+	enum class EntryState { Decoding, Decoded, Uploaded, Failed };
+
+	/**
+	 * @brief One image file, from request to upload.
+	 */
+	struct Entry {
+		std::filesystem::path path;
+		TextureRole role = TextureRole::BaseColor;
+		EntryState state = EntryState::Decoding;
+		TextureLevels levels;
+		uint64_t contentHash = 0;
+		// Set when another entry turned out to have identical file contents.
+		std::shared_ptr<Entry> alias;
+		// The uploaded texture, owned by the meshes that use it.
+		std::weak_ptr<const Texture> texture;
+		// Holds a texture uploaded by uploadReady() until load() hands it to its first user.
+		std::shared_ptr<const Texture> unclaimed;
+		std::string error;
+		// Called once the image is decoded (or has failed, or turned out to be an alias).
+		std::vector<std::function<void()>> onDecoded;
+	};
+
+	ThreadPool& m_pool;
+	std::mutex m_mutex;
+	// What the cooker may produce; guarded by m_mutex and read once per decode.
+	TextureCookOptions m_cookOptions;
+	std::condition_variable m_decodedChanged;
+	std::unordered_map<std::string, std::shared_ptr<Entry>> m_byPath;
+	std::unordered_map<uint64_t, std::shared_ptr<Entry>> m_byContent;
+	// Decoded images waiting for the GL thread.
+	std::deque<std::shared_ptr<Entry>> m_uploadQueue;
+
+	std::shared_ptr<Entry> requestEntry(const std::filesystem::path& path, TextureRole role,
+		std::function<void()> onDecoded);
+	void decode(std::shared_ptr<Entry> entry);
+	void finishDecode(Entry& entry, EntryState state);
+	std::shared_ptr<const Texture> upload(Entry& entry);
+	void forget(const std::shared_ptr<Entry>& entry);
+
+public:
+	explicit TextureService(ThreadPool& pool);
+	TextureService(const TextureService&) = delete;
+	TextureService& operator=(const TextureService&) = delete;
+
+	/**
+	 * @brief The service shared by every scene and model in the process.
+	 */
+	static TextureService& instance();
+
+	/**
+	 * @brief Queries the GL context for compressed format support. Call once on the GL thread,
+	 * after the context is created and before requesting any textures.
+	 */
+	void detectCapabilities();
+
+	/**
+	 * @brief Turns block compression on or off for textures decoded from now on. Compression
+	 * is on by default; turning it off trades VRAM for exact colors. Cooked files for both
+	 * settings are cached side by side.
+	 */
+	void setCompressionEnabled(bool enabled);
+
+	/**
+	 * @brief Starts decoding and cooking the image at the given path for the given role on a
+	 * worker thread, unless it is already known. The optional callback runs once the image has been decoded, possibly on a worker
+	 * thread, or immediately if it already has been. May be called from any thread.
+	 */
+	void request(const std::filesystem::path& path, TextureRole role, std::function<void()> onDecoded = nullptr);
+
+	/**
+	 * @brief Returns a texture for the image at the given path, bound to the given sampler name
+	 * (which also decides its role), waiting for it to decode and uploading it if necessary. Must be called on the GL thread.
+	 * @throws std::runtime_error if the image could not be loaded.
+	 */
+	TextureBinding load(const std::filesystem::path& path, const std::string& samplerName);
+
+	/**
+	 * @brief Uploads every image that has finished decoding, without blocking.
+	 * Must be called on the GL thread. Returns how many textures were uploaded.
+	 */
+	size_t uploadReady();
+
+	/**
+	 * @brief Deletes every texture uploadReady() uploaded that no load() has claimed, such as
+	 * those of a model whose import failed. Must be called on the GL thread, before the context
+	 * is destroyed; the service lives until the end of the process, after the window.
+	 */
+	void clear();
+};
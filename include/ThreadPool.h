@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads that run queued tasks in FIFO order.
+ * Tasks must not touch OpenGL; the GL context belongs to the main thread.
+ */
+class ThreadPool {
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_available;
+	bool m_stopping;
+
+	void workerLoop();
+
+public:
+	explicit ThreadPool(size_t threadCount);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Queues a task to run on some worker thread.
+	 */
+	void enqueue(std::function<void()> task);
+
+	/**
+	 * @brief Queues a task and returns a future for its result. Exceptions thrown by the task
+	 * are rethrown from future::get().
+	 */
+	template <typename F>
+	auto submit(F&& function) -> std::future<std::invoke_result_t<F>> {
+		using Result = std::invoke_result_t<F>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+		auto result = task->get_future();
+		enqueue([task]() { (*task)(); });
+		return result;
+	}
+
+	/**
+	 * @brief The number of worker threads.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief The process-wide pool used for asset loading, sized to leave one core for the
+	 * main (GL) thread.
+	 */
+	static ThreadPool& shared();
+};
@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/ext.hpp>
+#include "Entity.h"
+#include "TransformKernel.h"
+
+/**
+ * @brief The transforms of every object hierarchy in the process, flattened into one array of
+ * nodes. Each node's parent, position, orientation (a unit quaternion), scale, rotation center,
+ * local matrix and world matrix live in separate contiguous arrays, indexed by the node's slot. Slots are in depth-first
+ * order: a parent always comes before its children, and a node's descendants follow it
+ * contiguously. updateWorld() can therefore compute every world matrix in one linear pass, and
+ * a walk over the slots can skip a whole subtree by jumping over its size.
+ *
+ * Matrices are cached: the setters mark a node dirty only when its value actually changes, and
+ * updateWorld() visits only the dirty nodes and their subtrees, so nodes that don't move, like
+ * the scenery, cost nothing per frame, and the cost of a frame scales with what moved rather than
+ * with the size of the scene.
+ *
+ * The simulation runs in fixed steps between beginStep() and endStep(), and the store remembers
+ * each node's position, orientation and scale from before the last step. The world matrices are
+ * only for drawing, so updateWorld() builds them between the two states, and motion looks smooth
+ * however the step rate compares to the frame rate. Changes made outside a step take effect at
+ * once, with nothing to interpolate from, as a teleport should.
+ *
+ * Every entity in the World has a node here; the store hands out the entities. Slots move when
+ * nodes are attached or destroyed, but entities don't. Slot numbers and references into the
+ * arrays are only good until the next create(), clone(), attach() or destroy().
+ *
+ * Must only be used on the main thread.
+ */
+class TransformStore {
+public:
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+private:
+	// The slot of each node's parent, or NO_PARENT for roots.
+	std::vector<uint32_t> m_parents;
+	// How many slots each node's subtree covers, including the node itself.
+	std::vector<uint32_t> m_subtreeSizes;
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::quat> m_orientations;
+	std::vector<glm::vec3> m_scales;
+	std::vector<glm::vec3> m_centers;
+	std::vector<glm::mat4> m_baseTransforms;
+	std::vector<glm::mat4> m_locals;
+	std::vector<glm::mat4> m_worlds;
+	// Set when the node's local matrix is out of date; updateWorld() clears it.
+	std::vector<uint8_t> m_dirty;
+	std::vector<Entity> m_entities;
+	// The state before the last step, which equals the current one for nodes it didn't move.
+	std::vector<glm::vec3> m_previousPositions;
+	std::vector<glm::quat> m_previousOrientations;
+	std::vector<glm::vec3> m_previousScales;
+	// Set when the last step moved the node; beginStep() clears it.
+	std::vector<uint8_t> m_moved;
+
+	// The slot and current generation of each entity index; the slot is UINT32_MAX for indices
+	// not in use.
+	std::vector<uint32_t> m_slots;
+	std::vector<uint32_t> m_generations;
+	std::vector<uint32_t> m_freeIndices;
+	// The dirty slots, in the order they were marked, for composeTransforms.
+	std::vector<uint32_t> m_rebuild;
+	// The moved slots, in the order they were marked.
+	std::vector<uint32_t> m_movedSlots;
+	// Set when slots have moved since m_rebuild and m_movedSlots were built, so they must be
+	// gathered again.
+	bool m_rescan = false;
+	bool m_stepping = false;
+	// The interpolated state of the slots being rebuilt, in the order of m_rebuild.
+	TransformBatch m_batch;
+
+	/**
+	 * @brief Calls the function with each of the per-slot arrays.
+	 */
+	template <typename Function>
+	void forEachColumn(Function function) {
+		function(m_parents);
+		function(m_subtreeSizes);
+		function(m_positions);
+		function(m_orientations);
+		function(m_scales);
+		function(m_centers);
+		function(m_baseTransforms);
+		function(m_locals);
+		function(m_worlds);
+		function(m_dirty);
+		function(m_entities);
+		function(m_previousPositions);
+		function(m_previousOrientations);
+		function(m_previousScales);
+		function(m_moved);
+	}
+
+	Entity allocateEntity(uint32_t slot);
+	void gatherFlags();
+
+	void markDirty(size_t slot) {
+		if (!m_dirty[slot]) {
+			m_dirty[slot] = 1;
+			m_rebuild.push_back(static_cast<uint32_t>(slot));
+		}
+	}
+
+	template <typename T>
+	void assign(std::vector<T>& column, size_t slot, const T& value) {
+		if (column[slot] != value) {
+			column[slot] = value;
+			markDirty(slot);
+		}
+	}
+
+	/**
+	 * @brief Assigns a value that is interpolated: within a step the node is marked as moved,
+	 * and outside one the previous state jumps along with it.
+	 */
+	template <typename T>
+	void assign(std::vector<T>& column, std::vector<T>& previous, size_t slot, const T& value) {
+		if (column[slot] != value) {
+			column[slot] = value;
+			markDirty(slot);
+			if (!m_stepping) {
+				previous[slot] = value;
+			}
+			else if (!m_moved[slot]) {
+				m_moved[slot] = 1;
+				m_movedSlots.push_back(static_cast<uint32_t>(slot));
+			}
+		}
+	}
+
+	/**
+	 * @brief Swaps the slot ranges [first, middle) and [middle, last), as std::rotate does,
+	 * and renumbers the parents and entities that pointed into them.
+	 */
+	void rotateSlots(uint32_t first, uint32_t middle, uint32_t last);
+
+public:
+	TransformStore() = default;
+	TransformStore(const TransformStore&) = delete;
+	TransformStore& operator=(const TransformStore&) = delete;
+
+	/**
+	 * @brief Adds a new entity as a root node with an identity transform on top of the given base
+	 * transform.
+	 */
+	Entity create(const glm::mat4& baseTransform);
+
+	/**
+	 * @brief Copies the node and its descendants into a new root, with the same transforms.
+	 * The copies are new entities, in the same order as the originals' slots. Returns the copy's root.
+	 */
+	Entity clone(Entity root);
+
+	/**
+	 * @brief Makes the root child the last child of parent, moving the child's subtree to the
+	 * end of the parent's.
+	 * @throws std::logic_error if child already has a parent, or is an ancestor of parent.
+	 */
+	void attach(Entity parent, Entity child);
+
+	/**
+	 * @brief Removes the node and its descendants, detaching it from its parent if it has one,
+	 * and retires their entities.
+	 */
+	void destroy(Entity node);
+
+	/**
+	 * @brief Starts a simulation step: the current state becomes the previous one.
+	 */
+	void beginStep();
+	void endStep() { m_stepping = false; }
+
+	/**
+	 * @brief Recomputes the local matrix of every node that changed since the last call, then the
+	 * world matrix of those nodes and all of their descendants, parents first. Slots outside the
+	 * changed subtrees are not visited. Nodes the last step moved are placed the given fraction
+	 * of the way from their previous state to their current one. Returns how many world matrices
+	 * were rebuilt.
+	 */
+	size_t updateWorld(float alpha = 1);
+
+	bool isAlive(Entity entity) const {
+		return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation
+			&& m_slots[entity.index] != UINT32_MAX;
+	}
+
+	size_t size() const { return m_entities.size(); }
+	size_t slotOf(Entity node) const { return m_slots[node.index]; }
+	Entity entityAt(size_t slot) const { return m_entities[slot]; }
+	uint32_t parentAt(size_t slot) const { return m_parents[slot]; }
+	uint32_t subtreeSizeAt(size_t slot) const { return m_subtreeSizes[slot]; }
+
+	const glm::vec3& positionAt(size_t slot) const { return m_positions[slot]; }
+	const glm::quat& orientationAt(size_t slot) const { return m_orientations[slot]; }
+	const glm::vec3& scaleAt(size_t slot) const { return m_scales[slot]; }
+	const glm::vec3& centerAt(size_t slot) const { return m_centers[slot]; }
+
+	// Setters, which mark the node dirty if the value changes. The rotation center is never
+	// interpolated.
+	void setPositionAt(size_t slot, const glm::vec3& position) { assign(m_positions, m_previousPositions, slot, position); }
+	void setOrientationAt(size_t slot, const glm::quat& orientation) { assign(m_orientations, m_previousOrientations, slot, orientation); }
+	void setScaleAt(size_t slot, const glm::vec3& scale) { assign(m_scales, m_previousScales, slot, scale); }
+	void setCenterAt(size_t slot, const glm::vec3& center) { assign(m_centers, slot, center); }
+	const glm::mat4& baseTransformAt(size_t slot) const { return m_baseTransforms[slot]; }
+	// The node's local matrix as of its current state, rather than as last drawn; composed on
+	// the spot, for the simulation.
+	glm::mat4 composeLocalAt(size_t slot) const;
+	// The local->parent and local->world matrices as of the last updateWorld(), as drawn.
+	const glm::mat4& localAt(size_t slot) const { return m_locals[slot]; }
+	const glm::mat4& worldAt(size_t slot) const { return m_worlds[slot]; }
+};
@@ -1,5 +1,5 @@
 #pragma once
-#include "Object3D.h"
+#include "World.h"
 #include "Animation.h"
 /**
  * @brief Translates an object at a continuous rate over an interval.
@@ -15,7 +15,13 @@ private:
 	 * @brief Advance the animation by the given time interval.
 	 */
 	void applyAnimation(float dt) override {
-		object().move(m_perSecond * dt);
+		auto& world = World::instance();
+		if (!world.isAlive(node())) {
+			return;
+		}
+		auto& transforms = world.transforms;
+		auto slot = transforms.slotOf(node());
+		transforms.setPositionAt(slot, transforms.positionAt(slot) + m_perSecond * dt);
 	}
 
 public:
@@ -23,6 +29,6 @@ public:
 	 * @brief Constructs a animation of a constant translation by the given total translation
 	 * distance, linearly interpolated across the given duration.
 	 */
-	TranslationAnimation(Object3D& object, float duration, const glm::vec3& totalTranslation) :
-		Animation(object, duration), m_perSecond(totalTranslation / duration) {}
+	TranslationAnimation(Entity node, float duration, const glm::vec3& totalTranslation) :
+		Animation(node, duration), m_perSecond(totalTranslation / duration) {}
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "Broadphase.h"
+#include "ComponentArray.h"
+#include "Components.h"
+#include "Entity.h"
+#include "PhysicsBodies.h"
+#include "TransformStore.h"
+
+/**
+ * @brief Every entity in the process and its components. Entities are handed out by the
+ * transform store, since every entity has a transform; the other components live in dense arrays
+ * that systems such as tickPhysics walk directly. Entities are generational handles, so code can
+ * hold on to them across any number of objects being added or removed, and check isAlive before
+ * using one that may have been destroyed.
+ *
+ * Must only be used on the main thread.
+ */
+class World {
+public:
+	TransformStore transforms;
+	ComponentArray<Renderable> renderables;
+	PhysicsBodies bodies;
+	ComponentArray<AnimationTarget> animations;
+	ComponentArray<StaticBounds> statics;
+	// The objects that take part in collision detection, by their root entities.
+	Broadphase broadphase;
+
+	World() = default;
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+
+	/**
+	 * @brief The world every object in the process belongs to.
+	 */
+	static World& instance();
+
+	bool isAlive(Entity entity) const {
+		return transforms.isAlive(entity);
+	}
+
+	/**
+	 * @brief Copies the entity and its descendants, with their transforms, renderables and
+	 * physics bodies; animations and collider membership are not copied, and a copy of a static hierarchy is kinematic
+	 * until it is placed and made static. Returns the copy's root.
+	 */
+	Entity clone(Entity root);
+
+	/**
+	 * @brief Destroys the entity and its descendants, with all of their components.
+	 */
+	void destroy(Entity root);
+};
@@ -6,8 +6,14 @@ layout (location=1) in vec3 vNormal;
 layout (location=2) in vec2 vTexCoord;
 layout (location=3) in vec3 vTangent;
 
-uniform mat4 projection;
-uniform mat4 view;
+// The camera's matrices, shared by every program through one uniform buffer (see Camera.h).
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPos;
+};
+
 uniform mat4 model;
 //light space matrix
 uniform mat4 lightSpaceMatrix;
@@ -23,7 +29,7 @@ out mat3 TBN;
 
 void main() {
     // Transform the vertex position from local space to clip space.
-    gl_Position = projection * view * model * vec4(vPosition, 1.0);
+    gl_Position = viewProjection * model * vec4(vPosition, 1.0);
     // Pass along the vertex texture coordinate.
     TexCoord = vTexCoord;
 
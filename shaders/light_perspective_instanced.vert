@@ -0,0 +1,54 @@
+#version 330
+// The instanced variant of light_perspective.vert: identical outputs, but the model matrix and
+// its normal matrix come from per-instance attributes (see RenderQueue) instead of the
+// "model" uniform, so every copy of a mesh is drawn in one call.
+layout (location=0) in vec3 vPosition;
+layout (location=1) in vec3 vNormal;
+layout (location=2) in vec2 vTexCoord;
+layout (location=3) in vec3 vTangent;
+// Locations 4-7 hold the model matrix's columns, and 8-10 the normal matrix's.
+layout (location=4) in mat4 iModel;
+layout (location=8) in mat3 iNormalMatrix;
+
+// The camera's matrices, shared by every program through one uniform buffer (see Camera.h).
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPos;
+};
+
+//light space matrix
+uniform mat4 lightSpaceMatrix;
+
+out vec2 TexCoord;
+out vec3 Normal;
+out vec3 FragWorldPos;
+out vec4 FragPosLightSpace;
+
+// update vertex shader for normal mapping. 
+// source: https://learnopengl.com/Advanced-Lighting/Normal-Mapping
+out mat3 TBN;
+
+void main() {
+    // Transform the vertex position from local space to clip space.
+    gl_Position = viewProjection * iModel * vec4(vPosition, 1.0);
+    // Pass along the vertex texture coordinate.
+    TexCoord = vTexCoord;
+
+    FragWorldPos = vec3(iModel * vec4(vPosition, 1.0));
+
+    // The normal matrix is computed once per instance on the CPU, not once per vertex.
+    Normal = iNormalMatrix * vNormal;
+
+    //calculate the light space fragment position
+    FragPosLightSpace = lightSpaceMatrix * vec4(FragWorldPos, 1.0);
+
+    // Implement the TBN values for a normal map
+    vec3 T = normalize(iNormalMatrix * vTangent);    
+    vec3 N = normalize(iNormalMatrix * vNormal);
+    T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T);
+
+    TBN = transpose(mat3(T, B, N));
+}
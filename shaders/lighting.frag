@@ -18,6 +18,9 @@ struct Material {
     float shininess;
 };
 
+// The light structs live in a std140 uniform block, mirrored by LightManager.h. Each vec3 is
+// followed by a float so that both share one 16-byte slot.
+
 // struct for directional lighting
 struct DirLight {
     vec3 direction;
@@ -30,25 +33,25 @@ struct DirLight {
 struct PointLight {
     vec3 position;
     float constant;
-    float linear;
-    float quadratic;
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 // struct for spotlights
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
+    float cutOff;
     vec3 specular;       
+    float outerCutOff;
 };
 
 
@@ -69,17 +72,19 @@ uniform sampler2D baseTexture;
 // uniform vec4 material; //manual version
 uniform Material material;
 
-// directional light to be modified in application
-uniform DirLight dirLight;
-
 // point lights for application. define a constant for array size
 #define MAX_POINT_LIGHTS 20
-uniform int numPointLights; //arrays must be defined at compile time, so loop through with this
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-
 #define MAX_SPOTLIGHTS 10
-uniform int numSpotLights;
-uniform SpotLight spotLights[MAX_SPOTLIGHTS];
+
+// Every light in the scene, shared by all lit programs through one uniform buffer.
+layout (std140) uniform Lights {
+    // directional light to be modified in application
+    DirLight dirLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    SpotLight spotLights[MAX_SPOTLIGHTS];
+    int numPointLights; //arrays must be defined at compile time, so loop through with this
+    int numSpotLights;
+};
 
 // Ambient light color.
 //uniform vec3 ambientColor;
@@ -88,8 +93,13 @@ uniform SpotLight spotLights[MAX_SPOTLIGHTS];
 //uniform vec3 directionalLight; // this is the "I" vector, not the "L" vector.
 //uniform vec3 directionalColor;
 
-// Location of the camera.
-uniform vec3 viewPos;
+// The camera's matrices, shared by every program through one uniform buffer (see Camera.h).
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPos;
+};
 
 
 //calculate shadows
@@ -211,12 +221,14 @@ void main() {
     // and specularIntensity.
     vec3 norm = normalize(Normal);
 
-    //vec3 norm = vec3(texture(material.normalMap, TexCoord));
-    //norm = normalize(norm * 2.0 - 1.0);
+    // Normal mapping is disabled, and no normal maps are loaded. Once it is back on, normal maps
+    // are cooked to BC5, which only stores x and y, so z has to be rebuilt from them.
+    //vec2 normXY = texture(material.normalMap, TexCoord).xy * 2.0 - 1.0;
+    //vec3 norm = vec3(normXY, sqrt(max(1.0 - dot(normXY, normXY), 0.0)));
     //norm = normalize(TBN * norm);
 
-    //vec3 eyeDir = normalize(TBN * (viewPos - FragWorldPos));
-    vec3 eyeDir = normalize(viewPos - FragWorldPos);
+    //vec3 eyeDir = normalize(TBN * (cameraPos - FragWorldPos));
+    vec3 eyeDir = normalize(cameraPos - FragWorldPos);
     
     // directional lighting
     vec3 result = CalcDirLight(dirLight, norm, eyeDir);
@@ -1,11 +1,17 @@
 #version 330
 layout (location=0) in vec3 vPosition;
 
-uniform mat4 projection;
-uniform mat4 view;
+// The camera's matrices, shared by every program through one uniform buffer (see Camera.h).
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPos;
+};
+
 uniform mat4 model;
 
 void main() {
     // Project the position to clip space.
-    gl_Position = projection * view * model * vec4(vPosition, 1.0);
+    gl_Position = viewProjection * model * vec4(vPosition, 1.0);
 }
\ No newline at end of file
@@ -4,8 +4,14 @@ layout (location=0) in vec3 vPosition;
 layout (location=1) in vec3 vNormal;
 layout (location=2) in vec2 vTexCoord;
 
-uniform mat4 projection;
-uniform mat4 view;
+// The camera's matrices, shared by every program through one uniform buffer (see Camera.h).
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPos;
+};
+
 uniform mat4 model;
 
 out vec2 TexCoord;
@@ -13,7 +19,7 @@ out vec3 Normal;
 
 void main() {
     // Transform the position to clip space.
-    gl_Position = projection * view * model * vec4(vPosition, 1.0);
+    gl_Position = viewProjection * model * vec4(vPosition, 1.0);
     // Pass along the vertex texture coordinate.
     TexCoord = vTexCoord;
     // Transform the vertex normal from local space to world space, using the Normal matrix.
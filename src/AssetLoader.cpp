@@ -0,0 +1,127 @@
+#include "AssetLoader.h"
+#include "AssimpImport.h"
+#include "TextureService.h"
+#include <set>
+
+AssetLoader::AssetLoader(ThreadPool& pool) : m_pool(pool), m_inFlight(0) {
+}
+
+AssetLoader::~AssetLoader() {
+	// Worker tasks hold a pointer to this loader, so let them drain before it goes away.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_readyChanged.wait(lock, [this]() { return m_inFlight == 0; });
+}
+
+void AssetLoader::request(const std::string& key, const std::string& path, uint32_t importFlags) {
+	auto pending = std::make_shared<PendingModel>();
+	pending->key = key;
+	pending->path = path;
+	pending->importFlags = importFlags;
+	pending->remainingImages = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_pending.insert(key).second) {
+			return;
+		}
+		m_inFlight++;
+	}
+	m_pool.enqueue([this, pending]() { importModel(pending); });
+}
+
+void AssetLoader::importModel(std::shared_ptr<PendingModel> pending) {
+	try {
+		pending->model = loadModelData(pending->path, pending->importFlags);
+	}
+	catch (...) {
+		fail(*pending, std::current_exception());
+		finishStageOne(pending);
+		return;
+	}
+
+	// Decode each distinct image the model uses as its own task, so one model with many large
+	// textures spreads across the whole pool. The model is handed to the GL thread once the last
+	// of them is done; the extra count keeps that from happening while we are still requesting.
+	auto modelDirectory = std::filesystem::path(pending->path).parent_path();
+	std::set<std::pair<std::string, TextureRole>> images;
+	for (auto& mesh : pending->model.meshes) {
+		for (auto& texture : mesh.textures) {
+			images.emplace(texture.path, textureRoleFor(texture.samplerName));
+		}
+	}
+	pending->remainingImages = images.size() + 1;
+	for (auto& image : images) {
+		TextureService::instance().request(modelDirectory / image.first, image.second,
+			[this, pending]() { imageDecoded(pending); });
+	}
+	imageDecoded(pending);
+}
+
+void AssetLoader::imageDecoded(std::shared_ptr<PendingModel> pending) {
+	if (--pending->remainingImages == 0) {
+		finishStageOne(pending);
+	}
+}
+
+void AssetLoader::fail(PendingModel& pending, std::exception_ptr error) {
+	std::lock_guard<std::mutex> lock(pending.errorMutex);
+	if (!pending.error) {
+		pending.error = error;
+	}
+}
+
+void AssetLoader::finishStageOne(std::shared_ptr<PendingModel> pending) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_ready.push_back(std::move(pending));
+	m_inFlight--;
+	m_readyChanged.notify_all();
+}
+
+bool AssetLoader::isPending(const std::string& key) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending.count(key) > 0;
+}
+
+bool AssetLoader::hasPending() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return !m_pending.empty();
+}
+
+size_t AssetLoader::upload(std::deque<std::shared_ptr<PendingModel>>& ready, const LoadedCallback& onLoaded) {
+	size_t uploaded = 0;
+	while (!ready.empty()) {
+		auto pending = std::move(ready.front());
+		ready.pop_front();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending.erase(pending->key);
+		}
+		if (pending->error) {
+			// Put back the models we have not reached yet, so a caller that catches this can keep going.
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_ready.insert(m_ready.begin(), ready.begin(), ready.end());
+			std::rethrow_exception(pending->error);
+		}
+		onLoaded(pending->key, buildObject(pending->model, std::filesystem::path(pending->path)));
+		uploaded++;
+	}
+	return uploaded;
+}
+
+size_t AssetLoader::uploadReady(const LoadedCallback& onLoaded) {
+	std::deque<std::shared_ptr<PendingModel>> ready;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ready.swap(m_ready);
+	}
+	return upload(ready, onLoaded);
+}
+
+size_t AssetLoader::waitForAny(const LoadedCallback& onLoaded) {
+	std::deque<std::shared_ptr<PendingModel>> ready;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_readyChanged.wait(lock, [this]() { return !m_ready.empty() || m_pending.empty(); });
+		ready.swap(m_ready);
+	}
+	return upload(ready, onLoaded);
+}
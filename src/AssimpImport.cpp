@@ -1,4 +1,6 @@
 #include "AssimpImport.h"
+#include "MeshCache.h"
+#include "TextureService.h"
 #include <iostream>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -9,33 +11,32 @@
 const size_t FLOATS_PER_VERTEX = 3;
 const size_t VERTICES_PER_FACE = 3;
 
-std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName, const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
-	std::vector<Texture> textures;
+void referenceMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName,
+	std::vector<TextureReference>& textures) {
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString name;
 		mat->GetTexture(type, i, &name);
-		std::filesystem::path texPath = modelPath.parent_path() / name.C_Str();
+		textures.push_back(TextureReference{ name.C_Str(), typeName });
+	}
+}
 
-		auto existing = loadedTextures.find(texPath);
-		if (existing != loadedTextures.end()) {
-			textures.push_back(existing->second);
-		}
-		else {
-			StbImage image;
-			image.loadFromFile(texPath.string());
-			Texture tex = Texture::loadImage(image, typeName);
-			textures.push_back(tex);
-			loadedTextures.insert(std::make_pair(texPath, tex));
-		}
+std::vector<TextureBinding> loadMaterialTextures(const std::vector<TextureReference>& references,
+	const std::filesystem::path& modelPath) {
+	// The TextureService shares each image with every other mesh, model, and scene that uses it,
+	// and has usually decoded it on a worker thread already.
+	std::vector<TextureBinding> textures;
+	for (auto& reference : references)
+	{
+		std::filesystem::path texPath = modelPath.parent_path() / reference.path;
+		textures.push_back(TextureService::instance().load(texPath, reference.samplerName));
 	}
 	return textures;
 }
 
-Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
-	std::vector<Vertex3D> vertices;
+MeshData fromAssimpMesh(const aiMesh* mesh, const aiScene* scene) {
+	MeshData data;
+	auto& vertices = data.ownedVertices;
 
 	// DONE: fill in this vertices list, by iterating over each element of 
 	// the mVertices field of the aiMesh pointer. Each element of mVertices
@@ -44,6 +45,7 @@ Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::files
 	// x and y fields of each element of mTextureCoords.
 	// To find the normal vector of a vertex, access the x, y, and z fields
 	// of each eleemnt of mNormals.
+	vertices.reserve(mesh->mNumVertices);
 	for (size_t i = 0; i < mesh->mNumVertices; i++) {
 		auto& meshVertex = mesh->mVertices[i];
 		auto& texCoord = mesh->mTextureCoords[0][i];
@@ -56,12 +58,13 @@ Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::files
 
 	}
 
-	std::vector<uint32_t> faces;
+	auto& faces = data.ownedFaces;
 	// TODO: fill in the faces list, by iterating over each element of
 	// the mFaces field of the aiMesh pointer. Each element of mFaces
 	// has an mIndices list, which will have three elements of its own at 
 	// [0], [1], and [2]. Each of those should be pushed individually onto 
 	// the faces list.
+	faces.reserve(mesh->mNumFaces * VERTICES_PER_FACE);
 	for (size_t i = 0; i < mesh->mNumFaces; i++) {
 		auto& meshFace = mesh->mFaces[i];
 		// See above.
@@ -72,38 +75,46 @@ Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::files
 
 	}
 
-	// Load any base textures, specular maps, and normal maps associated with the mesh.
-	std::vector<Texture> textures = {};
+	// Record any base textures and specular maps associated with the mesh.
+	// They are loaded when the mesh is uploaded, so that a cached mesh still picks up edited images.
+	// Normal maps are left out while normal mapping is disabled in lighting.frag, so they are not
+	// decoded, cooked, and uploaded for nothing.
 	if (mesh->mMaterialIndex >= 0)
 	{
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		std::vector<Texture> diffuseMaps = loadMaterialTextures(material,
-			aiTextureType_DIFFUSE, "material.baseTexture", modelPath, loadedTextures);
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-		std::vector<Texture> specularMaps = loadMaterialTextures(material,
-			aiTextureType_SPECULAR, "material.specularMap", modelPath, loadedTextures);
-		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-		std::vector<Texture> heightMaps = loadMaterialTextures(material,
-			aiTextureType_HEIGHT, "heightMap", modelPath, loadedTextures);
-		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-		std::vector<Texture> normalMaps = loadMaterialTextures(material,
-			aiTextureType_NORMALS, "material.normalMap", modelPath, loadedTextures);
-		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+		referenceMaterialTextures(material, aiTextureType_DIFFUSE, "material.baseTexture", data.textures);
+		referenceMaterialTextures(material, aiTextureType_SPECULAR, "material.specularMap", data.textures);
+		referenceMaterialTextures(material, aiTextureType_HEIGHT, "heightMap", data.textures);
+		//referenceMaterialTextures(material, aiTextureType_NORMALS, "material.normalMap", data.textures);
 	}
 
-	return Mesh3D(std::move(vertices), std::move(faces), std::move(textures));
+	data.vertices = data.ownedVertices;
+	data.faces = data.ownedFaces;
+	return data;
 }
 
 
+uint32_t assimpImportFlags(bool flipTextureCoords) {
+	uint32_t options = aiProcessPreset_TargetRealtime_MaxQuality;
+	if (flipTextureCoords) {
+		options |= aiProcess_FlipUVs;
+	}
+	return options;
+}
 
 Object3D assimpLoad(const std::string& path, bool flipTextureCoords) {
-	Assimp::Importer importer;
+	auto model = loadModelData(path, assimpImportFlags(flipTextureCoords));
+	return buildObject(model, std::filesystem::path(path));
+}
 
-	auto options = aiProcessPreset_TargetRealtime_MaxQuality;
-	if (flipTextureCoords) {
-		options |= aiProcess_FlipUVs;
+ModelData loadModelData(const std::string& path, uint32_t importFlags) {
+	ModelData model;
+	if (loadMeshCache(path, importFlags, model)) {
+		return model;
 	}
-	const aiScene* scene = importer.ReadFile(path, options);
+
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(path, importFlags);
 
 	// If the import failed, report it
 	if (nullptr == scene) {
@@ -112,42 +123,66 @@ Object3D assimpLoad(const std::string& path, bool flipTextureCoords) {
 		throw std::runtime_error("Error loading assimp file: " + std::string(error));
 
 	}
-	else {
 
+	model.meshes.reserve(scene->mNumMeshes);
+	for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+		model.meshes.emplace_back(fromAssimpMesh(scene->mMeshes[i], scene));
 	}
-	std::vector<Mesh3D> meshes;
-	std::unordered_map<std::filesystem::path, Texture> loadedTextures;
-	auto ret = processAssimpNode(scene->mRootNode, scene, std::filesystem::path(path), loadedTextures);
-	return ret;
-}
+	processAssimpNode(scene->mRootNode, -1, model);
 
-Object3D processAssimpNode(aiNode* node, const aiScene* scene,
-	const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
-
-	// Load the aiNode's meshes.
-	std::vector<Mesh3D> meshes;
-	for (auto i = 0; i < node->mNumMeshes; i++) {
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.emplace_back(fromAssimpMesh(mesh, scene, modelPath, loadedTextures));
-	}
+	storeMeshCache(path, importFlags, model);
+	return model;
+}
 
-	std::vector<Texture> textures;
-	for (auto& p : loadedTextures) {
-		textures.push_back(p.second);
-	}
-	glm::mat4 baseTransform;
+void processAssimpNode(aiNode* node, int32_t parent, ModelData& model) {
+	// Nodes are flattened in pre-order, so a node's parent is always already in the list.
+	NodeData data;
+	data.name = node->mName.C_Str();
+	data.parent = parent;
+	data.meshes.assign(node->mMeshes, node->mMeshes + node->mNumMeshes);
 	for (auto i = 0; i < 4; i++) {
 		for (auto j = 0; j < 4; j++) {
-			baseTransform[i][j] = node->mTransformation[j][i];
+			data.baseTransform[i][j] = node->mTransformation[j][i];
 		}
 	}
-	auto parent = Object3D(std::move(meshes), baseTransform);
+	auto index = static_cast<int32_t>(model.nodes.size());
+	model.nodes.push_back(std::move(data));
 
 	for (auto i = 0; i < node->mNumChildren; i++) {
-		Object3D child = processAssimpNode(node->mChildren[i], scene, modelPath, loadedTextures);
-		parent.addChild(std::move(child));
+		processAssimpNode(node->mChildren[i], index, model);
+	}
+}
+
+/**
+ * @brief Builds the Object3D for one node and, recursively, its children.
+ */
+Object3D buildNode(const ModelData& model, size_t nodeIndex, const std::vector<std::shared_ptr<const Mesh3D>>& meshes,
+	const std::vector<std::vector<size_t>>& children) {
+	auto& node = model.nodes[nodeIndex];
+	std::vector<std::shared_ptr<const Mesh3D>> nodeMeshes;
+	for (auto meshIndex : node.meshes) {
+		nodeMeshes.push_back(meshes[meshIndex]);
 	}
+	auto object = Object3D(std::move(nodeMeshes), node.baseTransform);
+	object.setName(node.name);
+	for (auto child : children[nodeIndex]) {
+		object.addChild(buildNode(model, child, meshes, children));
+	}
+	return object;
+}
 
-	return parent;
+Object3D buildObject(const ModelData& model, const std::filesystem::path& modelPath) {
+	// Upload each mesh once, even if several nodes reference it; they share it.
+	std::vector<std::shared_ptr<const Mesh3D>> meshes;
+	meshes.reserve(model.meshes.size());
+	for (auto& mesh : model.meshes) {
+		meshes.push_back(std::make_shared<const Mesh3D>(mesh.vertices, mesh.faces,
+			loadMaterialTextures(mesh.textures, modelPath)));
+	}
+
+	std::vector<std::vector<size_t>> children(model.nodes.size());
+	for (size_t i = 1; i < model.nodes.size(); i++) {
+		children[model.nodes[i].parent].push_back(i);
+	}
+	return buildNode(model, 0, meshes, children);
 }
@@ -0,0 +1,328 @@
+#include "Broadphase.h"
+#include <algorithm>
+
+uint32_t Broadphase::proxyOf(Entity entity) const {
+	if (entity.index >= m_proxyOf.size()) {
+		return ABSENT;
+	}
+	auto proxy = m_proxyOf[entity.index];
+	// A stale handle whose index has been reused by another entity.
+	if (proxy != ABSENT && m_proxies[proxy].entity != entity) {
+		return ABSENT;
+	}
+	return proxy;
+}
+
+void Broadphase::insert(Entity entity, const Aabb& box, bool isStatic) {
+	auto proxy = proxyOf(entity);
+	if (proxy == ABSENT) {
+		if (m_freeProxies.empty()) {
+			proxy = static_cast<uint32_t>(m_proxies.size());
+			m_proxies.emplace_back();
+		}
+		else {
+			proxy = m_freeProxies.back();
+			m_freeProxies.pop_back();
+		}
+		if (entity.index >= m_proxyOf.size()) {
+			m_proxyOf.resize(entity.index + 1, ABSENT);
+		}
+		m_proxyOf[entity.index] = proxy;
+		m_proxies[proxy].entity = entity;
+		m_proxies[proxy].openIndex = ABSENT;
+		m_proxies[proxy].pairCount = 0;
+		for (auto& endpoints : m_endpoints) {
+			endpoints.push_back(Endpoint{ 0, proxy << 1 });
+			endpoints.push_back(Endpoint{ 0, (proxy << 1) | 1 });
+		}
+		m_rebuild = true;
+	}
+	// Which pairs it may be in changes without any end moving.
+	else if (m_proxies[proxy].isStatic != isStatic) {
+		m_rebuild = true;
+	}
+	m_proxies[proxy].box = box;
+	m_proxies[proxy].isStatic = isStatic;
+}
+
+void Broadphase::remove(Entity entity) {
+	auto proxy = proxyOf(entity);
+	if (proxy == ABSENT) {
+		return;
+	}
+	for (auto& endpoints : m_endpoints) {
+		std::erase_if(endpoints, [&](const Endpoint& endpoint) { return endpoint.proxy() == proxy; });
+	}
+	removePairsOf(proxy);
+	m_proxies[proxy].entity = Entity();
+	m_freeProxies.push_back(proxy);
+	m_proxyOf[entity.index] = ABSENT;
+}
+
+bool Broadphase::overlaps(uint32_t a, uint32_t b) const {
+	auto& first = m_proxies[a];
+	auto& second = m_proxies[b];
+	auto& box = first.box;
+	auto& other = second.box;
+	return a != b && box.min.x <= other.max.x && other.min.x <= box.max.x
+		&& box.min.y <= other.max.y && other.min.y <= box.max.y
+		&& box.min.z <= other.max.z && other.min.z <= box.max.z
+		&& !(first.isStatic && second.isStatic) && !box.isEmpty() && !other.isEmpty();
+}
+
+bool Broadphase::overlapsAfter(uint32_t a, uint32_t b, int axis) const {
+	auto& box = m_proxies[a].box;
+	auto& other = m_proxies[b].box;
+	for (int otherAxis = axis + 1; otherAxis < 3; otherAxis++) {
+		if (!(box.min[otherAxis] <= other.max[otherAxis] && other.min[otherAxis] <= box.max[otherAxis])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Broadphase::indexPairs() {
+	m_pairKeys.clear();
+	m_pairIndex.clear();
+	for (auto& proxy : m_proxies) {
+		proxy.pairCount = 0;
+	}
+	for (uint32_t i = 0; i < m_pairs.size(); i++) {
+		auto a = m_proxyOf[m_pairs[i].first.index];
+		auto b = m_proxyOf[m_pairs[i].second.index];
+		auto key = pairKey(a, b);
+		m_pairKeys.push_back(key);
+		m_pairIndex.emplace(key, i);
+		m_proxies[a].pairCount++;
+		m_proxies[b].pairCount++;
+	}
+	m_indexed = true;
+}
+
+void Broadphase::addPair(uint32_t a, uint32_t b) {
+	auto key = pairKey(a, b);
+	auto [it, inserted] = m_pairIndex.try_emplace(key, static_cast<uint32_t>(m_pairs.size()));
+	if (inserted) {
+		m_pairs.push_back(CollisionPair{ m_proxies[a].entity, m_proxies[b].entity });
+		m_pairKeys.push_back(key);
+		m_proxies[a].pairCount++;
+		m_proxies[b].pairCount++;
+	}
+}
+
+void Broadphase::removePair(uint32_t a, uint32_t b) {
+	if (m_proxies[a].pairCount == 0 || m_proxies[b].pairCount == 0) {
+		return;
+	}
+	auto it = m_pairIndex.find(pairKey(a, b));
+	if (it == m_pairIndex.end()) {
+		return;
+	}
+	m_proxies[a].pairCount--;
+	m_proxies[b].pairCount--;
+	// The last pair takes its place.
+	auto index = it->second;
+	m_pairIndex.erase(it);
+	if (index + 1 != m_pairs.size()) {
+		m_pairs[index] = m_pairs.back();
+		m_pairKeys[index] = m_pairKeys.back();
+		m_pairIndex[m_pairKeys[index]] = index;
+	}
+	m_pairs.pop_back();
+	m_pairKeys.pop_back();
+}
+
+void Broadphase::removePairsOf(uint32_t proxy) {
+	if (!m_indexed) {
+		auto entity = m_proxies[proxy].entity;
+		std::erase_if(m_pairs, [&](const CollisionPair& pair) { return pair.first == entity || pair.second == entity; });
+		return;
+	}
+	for (size_t i = 0; i < m_pairKeys.size();) {
+		auto key = m_pairKeys[i];
+		auto low = static_cast<uint32_t>(key);
+		auto high = static_cast<uint32_t>(key >> 32);
+		if (low == proxy || high == proxy) {
+			// Brings the last pair here, so look at this index again.
+			removePair(low, high);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void Broadphase::loadValues(int axis) {
+	for (auto& endpoint : m_endpoints[axis]) {
+		auto& box = m_proxies[endpoint.proxy()].box;
+		endpoint.value = endpoint.isMax() ? box.max[axis] : box.min[axis];
+	}
+}
+
+void Broadphase::swapPairs(Endpoint moved, Endpoint passed, int axis) {
+	// A max now ends before the other box starts. If the boxes end up apart on an axis still
+	// to be sorted as well, that axis's swaps remove the pair, so the lookup is only needed here
+	// when they don't.
+	if (moved.isMax()) {
+		if (overlapsAfter(moved.proxy(), passed.proxy(), axis)) {
+			removePair(moved.proxy(), passed.proxy());
+		}
+	}
+	// A min now starts before the other box ends. The values are all current, so this checks
+	// the other axes as they will be sorted.
+	else if (overlaps(moved.proxy(), passed.proxy())) {
+		addPair(moved.proxy(), passed.proxy());
+	}
+}
+
+template <bool UPDATE_PAIRS>
+size_t Broadphase::sortAxis(int axis) {
+	loadValues(axis);
+	auto& endpoints = m_endpoints[axis];
+	// Last step's order is nearly right, so each endpoint moves only a few places, if any. Each
+	// place it moves swaps it with one other end, and only a min passing a max, or a max passing
+	// a min, changes whether their boxes overlap along this axis.
+	size_t crossings = 0;
+	for (size_t i = 1; i < endpoints.size(); i++) {
+		auto endpoint = endpoints[i];
+		auto j = i;
+		while (j > 0 && endpoint < endpoints[j - 1]) {
+			auto& passed = endpoints[j - 1];
+			bool crosses = endpoint.isMax() != passed.isMax();
+			crossings += crosses;
+			if constexpr (UPDATE_PAIRS) {
+				if (crosses) {
+					swapPairs(endpoint, passed, axis);
+				}
+			}
+			endpoints[j] = passed;
+			j--;
+		}
+		endpoints[j] = endpoint;
+	}
+	return crossings;
+}
+
+void Broadphase::chooseSweepAxis() {
+	glm::vec3 sum(0);
+	glm::vec3 sumOfSquares(0);
+	float count = 0;
+	for (auto& proxy : m_proxies) {
+		if (!proxy.entity.isNull() && !proxy.box.isEmpty()) {
+			auto center = proxy.box.center();
+			sum += center;
+			sumOfSquares += center * center;
+			count++;
+		}
+	}
+	m_sweepAxis = 0;
+	if (count > 0) {
+		auto mean = sum / count;
+		auto variance = sumOfSquares / count - mean * mean;
+		for (int axis = 1; axis < 3; axis++) {
+			if (variance[axis] > variance[m_sweepAxis]) {
+				m_sweepAxis = axis;
+			}
+		}
+	}
+}
+
+void Broadphase::sweep() {
+	// Every pair is found once, so they are indexed only if the next step updates them.
+	m_pairs.clear();
+	m_indexed = false;
+	int otherAxis = (m_sweepAxis + 1) % 3;
+	int lastAxis = (m_sweepAxis + 2) % 3;
+	size_t tests = 0;
+	m_open.clear();
+	for (auto& endpoint : m_endpoints[m_sweepAxis]) {
+		auto id = endpoint.proxy();
+		auto& proxy = m_proxies[id];
+		if (endpoint.isMax()) {
+			// An empty box's max comes before its min, and it was never opened.
+			if (proxy.openIndex != ABSENT) {
+				auto& last = m_open.back();
+				m_proxies[last.proxy].openIndex = proxy.openIndex;
+				m_open[proxy.openIndex] = last;
+				m_open.pop_back();
+				proxy.openIndex = ABSENT;
+			}
+			continue;
+		}
+		auto& box = proxy.box;
+		if (box.isEmpty()) {
+			continue;
+		}
+		// Every open box overlaps this one along the sweep axis; check the other two.
+		OpenBox opened{ box.min[otherAxis], box.max[otherAxis], box.min[lastAxis], box.max[lastAxis], id, proxy.isStatic };
+		tests += m_open.size();
+		for (auto& other : m_open) {
+			if (opened.otherMin <= other.otherMax && other.otherMin <= opened.otherMax
+				&& opened.lastMin <= other.lastMax && other.lastMin <= opened.lastMax
+				&& !(opened.isStatic && other.isStatic)) {
+				m_pairs.push_back(CollisionPair{ m_proxies[other.proxy].entity, proxy.entity });
+			}
+		}
+		proxy.openIndex = static_cast<uint32_t>(m_open.size());
+		m_open.push_back(opened);
+	}
+	m_sweepTests = tests;
+}
+
+void Broadphase::startUpdating() {
+	// The other axes were last sorted before the sweeps began, and every box may have moved
+	// since, so they are sorted from scratch rather than by insertion.
+	for (int axis = 0; axis < 3; axis++) {
+		if (axis != m_sweepAxis) {
+			loadValues(axis);
+			std::sort(m_endpoints[axis].begin(), m_endpoints[axis].end());
+		}
+	}
+	m_sweeping = false;
+}
+
+const std::vector<CollisionPair>& Broadphase::findPairs() {
+	if (m_rebuild) {
+		chooseSweepAxis();
+		loadValues(m_sweepAxis);
+		std::sort(m_endpoints[m_sweepAxis].begin(), m_endpoints[m_sweepAxis].end());
+		sweep();
+		m_rebuild = false;
+		m_sweeping = true;
+		return m_pairs;
+	}
+	if (m_sweeping) {
+		// Only the sweep axis is sorted, so it stays the sweep axis, and the swaps along the other
+		// two are guessed from the last steps that updated the pairs.
+		auto crossings = sortAxis<false>(m_sweepAxis);
+		sweep();
+		if (crossings * m_crossingRatio * CROSSING_COST <= m_sweepTests) {
+			startUpdating();
+		}
+		return m_pairs;
+	}
+
+	if (!m_indexed) {
+		indexPairs();
+	}
+	size_t crossings = 0;
+	size_t sweepAxisCrossings = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		auto axisCrossings = sortAxis<true>(axis);
+		crossings += axisCrossings;
+		if (axis == m_sweepAxis) {
+			sweepAxisCrossings = axisCrossings;
+		}
+	}
+	if (crossings > 0) {
+		m_crossingRatio = static_cast<float>(crossings) / std::max<size_t>(sweepAxisCrossings, 1);
+	}
+	// Switching back and forth sorts two axes from scratch each time, so updating carries on
+	// until it costs clearly more than a sweep, not just a little. Every axis is sorted, so
+	// sweeping may start on whichever suits the boxes now.
+	if (crossings * CROSSING_COST > 2 * m_sweepTests) {
+		chooseSweepAxis();
+		m_sweeping = true;
+	}
+	return m_pairs;
+}
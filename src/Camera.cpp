@@ -0,0 +1,108 @@
+#include "Camera.h"
+#include "GLState.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+Camera::Camera(const glm::vec3& position, float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
+	: m_position(position), m_front(0, 0, -1), m_up(0, 1, 0), m_yaw(-90), m_pitch(0),
+	m_fieldOfView(fieldOfView), m_aspectRatio(aspectRatio), m_near(nearPlane), m_far(farPlane),
+	m_block(), m_buffer(0), m_viewDirty(true), m_projectionDirty(true) {
+	glGenBuffers(1, &m_buffer);
+	GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+	update();
+}
+
+Camera::~Camera() {
+	if (m_buffer != 0) {
+		GLState::instance().deleteBuffer(m_buffer);
+	}
+}
+
+Camera::Camera(Camera&& other) noexcept
+	: m_position(other.m_position), m_front(other.m_front), m_up(other.m_up), m_yaw(other.m_yaw),
+	m_pitch(other.m_pitch), m_fieldOfView(other.m_fieldOfView), m_aspectRatio(other.m_aspectRatio),
+	m_near(other.m_near), m_far(other.m_far), m_block(other.m_block), m_buffer(other.m_buffer),
+	m_viewDirty(other.m_viewDirty), m_projectionDirty(other.m_projectionDirty) {
+	other.m_buffer = 0;
+}
+
+void Camera::attach(ShaderProgram& program) const {
+	program.bindUniformBlock("Camera", CAMERA_BINDING);
+}
+
+void Camera::turn(float deltaYaw, float deltaPitch) {
+	m_yaw += deltaYaw;
+	m_pitch = std::clamp(m_pitch + deltaPitch, -89.0f, 89.0f);
+
+	// Euler angles, as in https://learnopengl.com/Getting-started/Camera. The front vector is
+	// cheap and movement needs it right away; the view matrix waits for update().
+	float yaw = glm::radians(m_yaw);
+	float pitch = glm::radians(m_pitch);
+	m_front = glm::normalize(glm::vec3(std::cos(yaw) * std::cos(pitch), std::sin(pitch), std::sin(yaw) * std::cos(pitch)));
+	m_viewDirty = true;
+}
+
+void Camera::move(const glm::vec3& offset) {
+	m_position += offset;
+	m_viewDirty = true;
+}
+
+void Camera::setAspectRatio(float aspectRatio) {
+	if (aspectRatio != m_aspectRatio) {
+		m_aspectRatio = aspectRatio;
+		m_projectionDirty = true;
+	}
+}
+
+bool Camera::update() {
+	// Another camera may have taken the binding point since last frame.
+	GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, m_buffer);
+	bool viewChanged = m_viewDirty;
+	if (!m_viewDirty && !m_projectionDirty) {
+		return false;
+	}
+	if (m_viewDirty) {
+		m_block.view = glm::lookAt(m_position, m_position + m_front, m_up);
+		m_block.position = m_position;
+		m_viewDirty = false;
+	}
+	if (m_projectionDirty) {
+		m_block.projection = glm::perspective(glm::radians(m_fieldOfView), m_aspectRatio, m_near, m_far);
+		m_projectionDirty = false;
+	}
+	m_block.viewProjection = m_block.projection * m_block.view;
+
+	GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &m_block);
+	return viewChanged;
+}
+
+const glm::vec3& Camera::getPosition() const {
+	return m_position;
+}
+
+const glm::vec3& Camera::getFront() const {
+	return m_front;
+}
+
+const glm::vec3& Camera::getUp() const {
+	return m_up;
+}
+
+float Camera::getFarPlane() const {
+	return m_far;
+}
+
+const glm::mat4& Camera::getView() const {
+	return m_block.view;
+}
+
+const glm::mat4& Camera::getProjection() const {
+	return m_block.projection;
+}
+
+const glm::mat4& Camera::getViewProjection() const {
+	return m_block.viewProjection;
+}
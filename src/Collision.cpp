@@ -0,0 +1,11 @@
+#include "Collision.h"
+
+Aabb colliderBox(const World& world, Entity root) {
+	auto& transforms = world.transforms;
+	return world.renderables.get(root).bounds.transformed(transforms.composeLocalAt(transforms.slotOf(root)));
+}
+
+const std::vector<CollisionPair>& findCollisionCandidates(World& world) {
+	world.broadphase.refresh([&](Entity entity) { return colliderBox(world, entity); });
+	return world.broadphase.findPairs();
+}
@@ -0,0 +1,69 @@
+#include "Frustum.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRUSTUM_SSE 1
+#include <emmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// Gribb and Hartmann: each plane is the fourth row of the matrix plus or minus another row.
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+	for (int i = 0; i < 3; i++) {
+		m_planes[i * 2] = rows[3] + rows[i];
+		m_planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+	for (auto& plane : m_planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+Containment Frustum::classify(const BoundingSphere& sphere) const {
+	auto result = Containment::Inside;
+	for (auto& plane : m_planes) {
+		float distance = plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w;
+		if (distance < -sphere.radius) {
+			return Containment::Outside;
+		}
+		if (distance < sphere.radius) {
+			result = Containment::Intersecting;
+		}
+	}
+	return result;
+}
+
+void Frustum::classify(const float* x, const float* y, const float* z, const float* radius, size_t count,
+	Containment* results) const {
+	size_t i = 0;
+#ifdef FRUSTUM_SSE
+	for (; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(x + i);
+		__m128 cy = _mm_loadu_ps(y + i);
+		__m128 cz = _mm_loadu_ps(z + i);
+		__m128 r = _mm_loadu_ps(radius + i);
+		__m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 outside = _mm_setzero_ps();
+		__m128 straddles = _mm_setzero_ps();
+		for (auto& plane : m_planes) {
+			// Same order of operations as classify(), so both give identical answers.
+			__m128 distance = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+			distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeR));
+			straddles = _mm_or_ps(straddles, _mm_cmplt_ps(distance, r));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+		int straddlesMask = _mm_movemask_ps(straddles);
+		for (int lane = 0; lane < 4; lane++) {
+			results[i + lane] = (outsideMask >> lane) & 1 ? Containment::Outside
+				: (straddlesMask >> lane) & 1 ? Containment::Intersecting
+				: Containment::Inside;
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		results[i] = classify(BoundingSphere{ glm::vec3(x[i], y[i], z[i]), radius[i] });
+	}
+}
@@ -0,0 +1,168 @@
+#include "GLState.h"
+
+GLState::GLState() {
+	invalidate();
+}
+
+GLState& GLState::instance() {
+	static GLState state;
+	return state;
+}
+
+void GLState::invalidate() {
+	m_program = 0;
+	m_vertexArray = 0;
+	m_arrayBuffer = 0;
+	m_uniformBuffer = 0;
+	for (auto& binding : m_uniformBindings) {
+		binding = 0;
+	}
+	m_activeTextureUnit = 0;
+	for (auto& texture : m_textures) {
+		texture = 0;
+	}
+	m_depthTest = false;
+	m_depthMask = true;
+	m_depthFunc = GL_LESS;
+}
+
+uint32_t* GLState::bufferSlot(uint32_t target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		return &m_arrayBuffer;
+	case GL_UNIFORM_BUFFER:
+		return &m_uniformBuffer;
+	default:
+		return nullptr;
+	}
+}
+
+void GLState::useProgram(uint32_t program) {
+	if (changes(m_program, program)) {
+		glUseProgram(program);
+	}
+}
+
+void GLState::bindVertexArray(uint32_t vertexArray) {
+	if (changes(m_vertexArray, vertexArray)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void GLState::bindBuffer(uint32_t target, uint32_t buffer) {
+	auto slot = bufferSlot(target);
+	if (slot == nullptr) {
+		m_stats.issued++;
+		glBindBuffer(target, buffer);
+	}
+	else if (changes(*slot, buffer)) {
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLState::bindBufferBase(uint32_t target, uint32_t index, uint32_t buffer) {
+	if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+		m_stats.issued++;
+		glBindBufferBase(target, index, buffer);
+		// The generic binding changed too, to a buffer we may not be tracking.
+		if (auto slot = bufferSlot(target)) {
+			*slot = buffer;
+		}
+		return;
+	}
+	if (changes(m_uniformBindings[index], buffer)) {
+		glBindBufferBase(target, index, buffer);
+		m_uniformBuffer = buffer;
+	}
+}
+
+void GLState::bindTexture(uint32_t unit, uint32_t texture) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		m_stats.issued += 2;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		m_activeTextureUnit = unit;
+		return;
+	}
+	if (m_textures[unit] == texture) {
+		m_stats.elided++;
+		return;
+	}
+	if (changes(m_activeTextureUnit, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	changes(m_textures[unit], texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::setDepthTest(bool enabled) {
+	if (m_depthTest == enabled) {
+		m_stats.elided++;
+		return;
+	}
+	m_depthTest = enabled;
+	m_stats.issued++;
+	if (enabled) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	else {
+		glDisable(GL_DEPTH_TEST);
+	}
+}
+
+void GLState::setDepthMask(bool enabled) {
+	if (m_depthMask == enabled) {
+		m_stats.elided++;
+		return;
+	}
+	m_depthMask = enabled;
+	m_stats.issued++;
+	glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::setDepthFunc(uint32_t func) {
+	if (changes(m_depthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+void GLState::deleteBuffer(uint32_t buffer) {
+	if (buffer == 0) {
+		return;
+	}
+	glDeleteBuffers(1, &buffer);
+	// GL unbinds a deleted buffer from the current bindings; mirror that.
+	if (m_arrayBuffer == buffer) {
+		m_arrayBuffer = 0;
+	}
+	if (m_uniformBuffer == buffer) {
+		m_uniformBuffer = 0;
+	}
+	for (auto& binding : m_uniformBindings) {
+		if (binding == buffer) {
+			binding = 0;
+		}
+	}
+}
+
+void GLState::deleteVertexArray(uint32_t vertexArray) {
+	if (vertexArray == 0) {
+		return;
+	}
+	glDeleteVertexArrays(1, &vertexArray);
+	if (m_vertexArray == vertexArray) {
+		m_vertexArray = 0;
+	}
+}
+
+void GLState::deleteTexture(uint32_t texture) {
+	if (texture == 0) {
+		return;
+	}
+	glDeleteTextures(1, &texture);
+	for (auto& bound : m_textures) {
+		if (bound == texture) {
+			bound = 0;
+		}
+	}
+}
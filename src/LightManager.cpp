@@ -0,0 +1,112 @@
+#include "LightManager.h"
+#include "GLState.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+LightManager::LightManager() : m_buffer(0), m_dirtyBegin(0), m_dirtyEnd(0) {
+	// glm vectors are not zeroed by their constructors.
+	std::memset(static_cast<void*>(&m_block), 0, sizeof(m_block));
+	glGenBuffers(1, &m_buffer);
+	GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &m_block, GL_DYNAMIC_DRAW);
+	GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, m_buffer);
+}
+
+LightManager::~LightManager() {
+	if (m_buffer != 0) {
+		GLState::instance().deleteBuffer(m_buffer);
+	}
+}
+
+LightManager::LightManager(LightManager&& other) noexcept
+	: m_block(other.m_block), m_buffer(other.m_buffer), m_dirtyBegin(other.m_dirtyBegin), m_dirtyEnd(other.m_dirtyEnd) {
+	other.m_buffer = 0;
+}
+
+void LightManager::attach(ShaderProgram& program) const {
+	program.bindUniformBlock("Lights", LIGHTS_BINDING);
+}
+
+void LightManager::markDirty(const void* field, size_t size) {
+	size_t begin = static_cast<const uint8_t*>(field) - reinterpret_cast<const uint8_t*>(&m_block);
+	if (m_dirtyBegin >= m_dirtyEnd) {
+		m_dirtyBegin = begin;
+		m_dirtyEnd = begin + size;
+		return;
+	}
+	m_dirtyBegin = std::min(m_dirtyBegin, begin);
+	m_dirtyEnd = std::max(m_dirtyEnd, begin + size);
+}
+
+void LightManager::setDirectionalLight(const DirectionalLight& light) {
+	m_block.dirLight = light;
+	markDirty(&m_block.dirLight, sizeof(light));
+}
+
+void LightManager::setPointLight(uint32_t index, const PointLight& light) {
+	if (index >= MAX_POINT_LIGHTS) {
+		throw std::out_of_range("Point light index out of bounds");
+	}
+	m_block.pointLights[index] = light;
+	markDirty(&m_block.pointLights[index], sizeof(light));
+	if (static_cast<int32_t>(index) >= m_block.numPointLights) {
+		m_block.numPointLights = index + 1;
+		markDirty(&m_block.numPointLights, sizeof(int32_t));
+	}
+}
+
+void LightManager::setSpotLight(uint32_t index, const SpotLight& light) {
+	if (index >= MAX_SPOTLIGHTS) {
+		throw std::out_of_range("Spotlight index out of bounds");
+	}
+	m_block.spotLights[index] = light;
+	markDirty(&m_block.spotLights[index], sizeof(light));
+	if (static_cast<int32_t>(index) >= m_block.numSpotLights) {
+		m_block.numSpotLights = index + 1;
+		markDirty(&m_block.numSpotLights, sizeof(int32_t));
+	}
+}
+
+void LightManager::moveSpotLight(uint32_t index, const glm::vec3& position, const glm::vec3& direction) {
+	if (index >= MAX_SPOTLIGHTS) {
+		throw std::out_of_range("Spotlight index out of bounds");
+	}
+	auto& light = m_block.spotLights[index];
+	light.position = position;
+	light.direction = direction;
+	markDirty(&light.position, offsetof(SpotLight, direction) + sizeof(glm::vec3));
+}
+
+void LightManager::setSpotLightColor(uint32_t index, const glm::vec3& ambient, const glm::vec3& diffuse,
+	const glm::vec3& specular) {
+	if (index >= MAX_SPOTLIGHTS) {
+		throw std::out_of_range("Spotlight index out of bounds");
+	}
+	auto& light = m_block.spotLights[index];
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	markDirty(&light.ambient, offsetof(SpotLight, specular) + sizeof(glm::vec3) - offsetof(SpotLight, ambient));
+}
+
+const SpotLight& LightManager::getSpotLight(uint32_t index) const {
+	if (index >= MAX_SPOTLIGHTS) {
+		throw std::out_of_range("Spotlight index out of bounds");
+	}
+	return m_block.spotLights[index];
+}
+
+void LightManager::upload() {
+	// Another manager (from another scene) may have taken the binding point since last frame.
+	GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, m_buffer);
+	if (m_dirtyBegin >= m_dirtyEnd) {
+		return;
+	}
+	GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, m_dirtyBegin, m_dirtyEnd - m_dirtyBegin,
+		reinterpret_cast<const uint8_t*>(&m_block) + m_dirtyBegin);
+	m_dirtyBegin = m_dirtyEnd = 0;
+}
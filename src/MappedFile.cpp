@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(nullptr), m_mapping(nullptr) {
+}
+#else
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_fd(-1) {
+}
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::filesystem::path& path) {
+	close();
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	m_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+
+	m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr) {
+		close();
+		return false;
+	}
+	m_data = static_cast<const std::byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (m_data != nullptr) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file != nullptr) {
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_file = nullptr;
+	m_size = 0;
+}
+#else
+bool MappedFile::open(const std::filesystem::path& path) {
+	close();
+	m_fd = ::open(path.c_str(), O_RDONLY);
+	if (m_fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(m_fd, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+	m_size = static_cast<size_t>(info.st_size);
+
+	void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (mapped == MAP_FAILED) {
+		close();
+		return false;
+	}
+	m_data = static_cast<const std::byte*>(mapped);
+	return true;
+}
+
+void MappedFile::close() {
+	if (m_data != nullptr) {
+		munmap(const_cast<std::byte*>(m_data), m_size);
+	}
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+	m_data = nullptr;
+	m_fd = -1;
+	m_size = 0;
+}
+#endif
+
+const std::byte* MappedFile::data() const {
+	return m_data;
+}
+
+size_t MappedFile::size() const {
+	return m_size;
+}
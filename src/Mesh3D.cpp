@@ -1,30 +1,46 @@
+#include <algorithm>
 #include <iostream>
 #include "Mesh3D.h"
+#include "TextureResidency.h"
+#include "GLState.h"
 #include <glad/glad.h>
 
 
 Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
-	Texture texture)
-	: Mesh3D(std::move(vertices), std::move(faces), std::vector<Texture>{texture}) {
+	TextureBinding texture)
+	: Mesh3D(std::move(vertices), std::move(faces), std::vector<TextureBinding>{std::move(texture)}) {
 }
 
-Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces, std::vector<Texture>&& textures)
-	: m_vertexCount(vertices.size()), m_faceCount(faces.size()), m_textures(textures) {
+Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces, std::vector<TextureBinding>&& textures)
+	: Mesh3D(std::span<const Vertex3D>(vertices), std::span<const uint32_t>(faces), std::move(textures)) {
+}
+
+Mesh3D::Mesh3D(std::span<const Vertex3D> vertices, std::span<const uint32_t> faces, std::vector<TextureBinding>&& textures)
+	: m_vao(0), m_vbo(0), m_ebo(0), m_vertexCount(vertices.size()), m_faceCount(faces.size()), m_textures(std::move(textures)) {
+
+	// Bounds for frustum culling: a box, and a sphere around the box's center that fits the
+	// vertices themselves (usually much tighter than the box's own sphere).
+	for (auto& vertex : vertices) {
+		m_bounds.merge(glm::vec3(vertex.x, vertex.y, vertex.z));
+	}
+	m_sphere = BoundingSphere{ m_bounds.isEmpty() ? glm::vec3(0) : m_bounds.center(), 0 };
+	for (auto& vertex : vertices) {
+		m_sphere.radius = std::max(m_sphere.radius, glm::distance(m_sphere.center, glm::vec3(vertex.x, vertex.y, vertex.z)));
+	}
 
 	// Generate a vertex array object on the GPU.
 	glGenVertexArrays(1, &m_vao);
 	// "Bind" the newly-generated vao, which makes future functions operate on that specific object.
-	glBindVertexArray(m_vao);
+	GLState::instance().bindVertexArray(m_vao);
 
 	// Generate a vertex buffer object on the GPU.
-	uint32_t vbo;
-	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &m_vbo);
 
 	// "Bind" the newly-generated vbo, which makes future functions operate on that specific object.
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GLState::instance().bindBuffer(GL_ARRAY_BUFFER, m_vbo);
 	// This vbo is now associated with m_vao.
 	// Copy the contents of the vertices list to the buffer that lives on the GPU.
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex3D), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex3D), vertices.data(), GL_STATIC_DRAW);
 	// Inform OpenGL how to interpret the buffer: each vertex is 3 floats for position...
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex3D), 0);
 	glEnableVertexAttribArray(0);
@@ -39,36 +55,89 @@ Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
 
 
 	// Generate a second buffer, to store the indices of each triangle in the mesh.
-	uint32_t ebo;
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(uint32_t), &faces[0], GL_STATIC_DRAW);
+	glGenBuffers(1, &m_ebo);
+	GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(uint32_t), faces.data(), GL_STATIC_DRAW);
 
 	// Unbind the vertex array, so no one else can accidentally mess with it.
-	glBindVertexArray(0);
+	GLState::instance().bindVertexArray(0);
 }
 
-void Mesh3D::addTexture(Texture texture) {
-	m_textures.push_back(texture);
+Mesh3D::~Mesh3D() {
+	auto& state = GLState::instance();
+	state.deleteVertexArray(m_vao);
+	state.deleteBuffer(m_vbo);
+	state.deleteBuffer(m_ebo);
 }
 
-void Mesh3D::render(ShaderProgram& program) const {
-	glBindVertexArray(m_vao);
-	for (auto i = 0; i < m_textures.size(); i++) {
-		program.setUniform(m_textures[i].samplerName, i);
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textures[i].textureId);
+Mesh3D::Mesh3D(Mesh3D&& other) noexcept
+	: m_vao(other.m_vao), m_vbo(other.m_vbo), m_ebo(other.m_ebo), m_textures(std::move(other.m_textures)),
+	m_vertexCount(other.m_vertexCount), m_faceCount(other.m_faceCount), m_bounds(other.m_bounds),
+	m_sphere(other.m_sphere) {
+	other.m_vao = other.m_vbo = other.m_ebo = 0;
+}
+
+Mesh3D& Mesh3D::operator=(Mesh3D&& other) noexcept {
+	if (this != &other) {
+		std::swap(m_vao, other.m_vao);
+		std::swap(m_vbo, other.m_vbo);
+		std::swap(m_ebo, other.m_ebo);
+		m_textures = std::move(other.m_textures);
+		m_vertexCount = other.m_vertexCount;
+		m_faceCount = other.m_faceCount;
+		m_bounds = other.m_bounds;
+		m_sphere = other.m_sphere;
+	}
+	return *this;
+}
+
+void Mesh3D::addTexture(TextureBinding texture) {
+	m_textures.push_back(std::move(texture));
+}
+
+uint32_t Mesh3D::getVao() const {
+	return m_vao;
+}
+
+uint32_t Mesh3D::getFaceCount() const {
+	return m_faceCount;
+}
+
+const Aabb& Mesh3D::getBounds() const {
+	return m_bounds;
+}
+
+const BoundingSphere& Mesh3D::getBoundingSphere() const {
+	return m_sphere;
+}
+
+const std::vector<TextureBinding>& Mesh3D::getTextures() const {
+	return m_textures;
+}
+
+void Mesh3D::bindTextures(ShaderProgram& program) const {
+	for (auto& texture : m_textures) {
+		// Each role has its own unit, so samplers keep their unit from mesh to mesh and only
+		// the textures that differ from the previous mesh's get bound.
+		auto unit = textureUnitFor(textureRoleFor(texture.samplerName));
+		program.setSampler(texture.samplerName, unit);
+		auto textureId = texture.texture->getId();
+		GLState::instance().bindTexture(unit, textureId);
+		TextureResidency::instance().touch(textureId);
 	}
+}
+
+void Mesh3D::render(ShaderProgram& program) const {
+	GLState::instance().bindVertexArray(m_vao);
+	bindTextures(program);
 
-	// Draw the vertex array, using its "element buffer" to identify the faces.
+	// Draw the vertex array, using its "element buffer" to identify the faces. The vertex array
+	// and textures stay bound, so the next mesh skips whichever binds it shares with this one.
 	glDrawElements(GL_TRIANGLES, m_faceCount, GL_UNSIGNED_INT, nullptr);
-	// Deactivate the mesh's vertex array and texture.
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
-Mesh3D Mesh3D::square(const std::vector<Texture>& textures) {
+Mesh3D Mesh3D::square(const std::vector<TextureBinding>& textures) {
 	return Mesh3D(
 		{
 			{ 20, 20, 0, 0, 0, 40, 40, 0 },    // TR
@@ -80,6 +149,6 @@ Mesh3D Mesh3D::square(const std::vector<Texture>& textures) {
 			2, 1, 3,
 			3, 1, 0,
 		},
-		std::vector<Texture>(textures)
+		std::vector<TextureBinding>(textures)
 	);
 }
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "MeshCache.h"
+#include "Hash.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+static_assert(sizeof(Vertex3D) == 8 * sizeof(float) && std::is_trivially_copyable_v<Vertex3D>,
+	"the mesh cache stores Vertex3D arrays verbatim; bump MESH_CACHE_VERSION if the layout changes");
+
+namespace {
+	const char MESH_CACHE_MAGIC[8] = { 'F', 'O', 'G', 'L', 'M', 'E', 'S', 'H' };
+	const std::filesystem::path MESH_CACHE_DIRECTORY = "cache/meshes";
+
+	struct CacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t importFlags;
+		int64_t sourceTime;
+		uint64_t sourceSize;
+		uint32_t pathLength;
+		uint32_t meshCount;
+		uint32_t nodeCount;
+		uint32_t reserved;
+	};
+
+	struct MeshRecord {
+		uint32_t vertexCount;
+		uint32_t faceCount;
+		uint32_t textureCount;
+	};
+
+	struct TextureRecord {
+		uint32_t pathLength;
+		uint32_t samplerLength;
+	};
+
+	struct NodeRecord {
+		int32_t parent;
+		uint32_t meshCount;
+		uint32_t nameLength;
+		float baseTransform[16];
+	};
+
+	/**
+	 * @brief Identifies the version of the source file that a cache entry was built from.
+	 */
+	struct SourceStamp {
+		int64_t time;
+		uint64_t size;
+	};
+
+	bool stampSource(const std::filesystem::path& modelPath, SourceStamp& stamp) {
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(modelPath, error);
+		if (error) {
+			return false;
+		}
+		auto size = std::filesystem::file_size(modelPath, error);
+		if (error) {
+			return false;
+		}
+		stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+		stamp.size = static_cast<uint64_t>(size);
+		return true;
+	}
+
+	size_t paddingFor(size_t length) {
+		return (4 - length % 4) % 4;
+	}
+
+	/**
+	 * @brief Walks a mapped cache file, handing out pointers to its records and arrays.
+	 * Any read past the end of the file fails instead of crashing on a truncated cache.
+	 */
+	class CacheReader {
+	private:
+		const std::byte* m_data;
+		size_t m_size;
+		size_t m_offset;
+
+	public:
+		CacheReader(const std::byte* data, size_t size) : m_data(data), m_size(size), m_offset(0) {}
+
+		template <typename T>
+		const T* take(size_t count) {
+			size_t bytes = sizeof(T) * count;
+			if (bytes > m_size - m_offset) {
+				return nullptr;
+			}
+			auto result = reinterpret_cast<const T*>(m_data + m_offset);
+			m_offset += bytes;
+			return result;
+		}
+
+		bool takeString(size_t length, std::string& out) {
+			auto chars = take<char>(length);
+			if (chars == nullptr || take<char>(paddingFor(length)) == nullptr) {
+				return false;
+			}
+			out.assign(chars, length);
+			return true;
+		}
+	};
+
+	class CacheWriter {
+	private:
+		std::ofstream& m_out;
+
+	public:
+		explicit CacheWriter(std::ofstream& out) : m_out(out) {}
+
+		template <typename T>
+		void put(const T* values, size_t count) {
+			m_out.write(reinterpret_cast<const char*>(values), sizeof(T) * count);
+		}
+
+		template <typename T>
+		void put(const T& value) {
+			put(&value, 1);
+		}
+
+		void putString(const std::string& text) {
+			const char zeros[4] = {};
+			m_out.write(text.data(), text.size());
+			m_out.write(zeros, paddingFor(text.size()));
+		}
+	};
+}
+
+std::filesystem::path meshCachePath(const std::filesystem::path& modelPath, uint32_t importFlags) {
+	uint64_t key = fnv1a(modelPath.generic_string());
+	key = fnv1a(&importFlags, sizeof(importFlags), key);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(key));
+	return MESH_CACHE_DIRECTORY / name;
+}
+
+bool loadMeshCache(const std::filesystem::path& modelPath, uint32_t importFlags, ModelData& model) {
+	SourceStamp stamp;
+	if (!stampSource(modelPath, stamp)) {
+		return false;
+	}
+
+	auto mapping = std::make_shared<MappedFile>();
+	if (!mapping->open(meshCachePath(modelPath, importFlags))) {
+		return false;
+	}
+	CacheReader reader(mapping->data(), mapping->size());
+
+	// Reject the cache if it was written by a different version of this code, for different
+	// import flags, for an older version of the source file, or (on a hash collision) for a
+	// different model altogether.
+	auto header = reader.take<CacheHeader>(1);
+	if (header == nullptr
+		|| std::memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0
+		|| header->version != MESH_CACHE_VERSION
+		|| header->importFlags != importFlags
+		|| header->sourceTime != stamp.time
+		|| header->sourceSize != stamp.size
+		|| header->nodeCount == 0) {
+		return false;
+	}
+	std::string sourcePath;
+	if (!reader.takeString(header->pathLength, sourcePath) || sourcePath != modelPath.generic_string()) {
+		return false;
+	}
+
+	ModelData result;
+	result.meshes.resize(header->meshCount);
+	for (auto& mesh : result.meshes) {
+		auto record = reader.take<MeshRecord>(1);
+		if (record == nullptr) {
+			return false;
+		}
+		auto vertices = reader.take<Vertex3D>(record->vertexCount);
+		auto faces = reader.take<uint32_t>(record->faceCount);
+		if (vertices == nullptr || faces == nullptr) {
+			return false;
+		}
+		mesh.vertices = std::span<const Vertex3D>(vertices, record->vertexCount);
+		mesh.faces = std::span<const uint32_t>(faces, record->faceCount);
+
+		mesh.textures.resize(record->textureCount);
+		for (auto& texture : mesh.textures) {
+			auto textureRecord = reader.take<TextureRecord>(1);
+			if (textureRecord == nullptr
+				|| !reader.takeString(textureRecord->pathLength, texture.path)
+				|| !reader.takeString(textureRecord->samplerLength, texture.samplerName)) {
+				return false;
+			}
+		}
+	}
+
+	result.nodes.resize(header->nodeCount);
+	for (size_t i = 0; i < result.nodes.size(); i++) {
+		auto& node = result.nodes[i];
+		auto record = reader.take<NodeRecord>(1);
+		// The root must come first, and every other node must follow its parent.
+		bool validParent = (i == 0) ? record != nullptr && record->parent == -1
+			: record != nullptr && record->parent >= 0 && record->parent < static_cast<int32_t>(i);
+		if (!validParent) {
+			return false;
+		}
+		auto meshes = reader.take<uint32_t>(record->meshCount);
+		if (meshes == nullptr || !reader.takeString(record->nameLength, node.name)) {
+			return false;
+		}
+		node.parent = record->parent;
+		std::memcpy(&node.baseTransform[0][0], record->baseTransform, sizeof(record->baseTransform));
+		node.meshes.assign(meshes, meshes + record->meshCount);
+		for (auto index : node.meshes) {
+			if (index >= result.meshes.size()) {
+				return false;
+			}
+		}
+	}
+
+	result.mapping = std::move(mapping);
+	model = std::move(result);
+	return true;
+}
+
+void storeMeshCache(const std::filesystem::path& modelPath, uint32_t importFlags, const ModelData& model) {
+	SourceStamp stamp;
+	if (!stampSource(modelPath, stamp)) {
+		return;
+	}
+
+	auto cachePath = meshCachePath(modelPath, importFlags);
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(cachePath.parent_path(), error);
+
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::cerr << "Could not write mesh cache " << tempPath << std::endl;
+			return;
+		}
+		CacheWriter writer(out);
+
+		auto sourcePath = modelPath.generic_string();
+		CacheHeader header = {};
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+		header.version = MESH_CACHE_VERSION;
+		header.importFlags = importFlags;
+		header.sourceTime = stamp.time;
+		header.sourceSize = stamp.size;
+		header.pathLength = static_cast<uint32_t>(sourcePath.size());
+		header.meshCount = static_cast<uint32_t>(model.meshes.size());
+		header.nodeCount = static_cast<uint32_t>(model.nodes.size());
+		writer.put(header);
+		writer.putString(sourcePath);
+
+		for (auto& mesh : model.meshes) {
+			MeshRecord record = {
+				static_cast<uint32_t>(mesh.vertices.size()),
+				static_cast<uint32_t>(mesh.faces.size()),
+				static_cast<uint32_t>(mesh.textures.size())
+			};
+			writer.put(record);
+			writer.put(mesh.vertices.data(), mesh.vertices.size());
+			writer.put(mesh.faces.data(), mesh.faces.size());
+			for (auto& texture : mesh.textures) {
+				TextureRecord textureRecord = {
+					static_cast<uint32_t>(texture.path.size()),
+					static_cast<uint32_t>(texture.samplerName.size())
+				};
+				writer.put(textureRecord);
+				writer.putString(texture.path);
+				writer.putString(texture.samplerName);
+			}
+		}
+
+		for (auto& node : model.nodes) {
+			NodeRecord record = {};
+			record.parent = node.parent;
+			record.meshCount = static_cast<uint32_t>(node.meshes.size());
+			record.nameLength = static_cast<uint32_t>(node.name.size());
+			std::memcpy(record.baseTransform, &node.baseTransform[0][0], sizeof(record.baseTransform));
+			writer.put(record);
+			writer.put(node.meshes.data(), node.meshes.size());
+			writer.putString(node.name);
+		}
+
+		if (!out) {
+			std::cerr << "Could not write mesh cache " << tempPath << std::endl;
+			out.close();
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+	}
+
+	// Publish the finished file in one step, so a crash mid-write never leaves a truncated cache.
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error) {
+		std::cerr << "Could not write mesh cache " << cachePath << ": " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+	}
+}
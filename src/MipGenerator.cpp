@@ -0,0 +1,238 @@
+#include "MipGenerator.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIP_GENERATOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC emits AVX2 intrinsics without any per-function opt-in.
+#define MIP_TARGET_AVX2
+#else
+#define MIP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+	/**
+	 * @brief Downsamples output bytes [begin, end) of one row from the two source rows under it.
+	 * Also the reference every SIMD kernel must match bit for bit.
+	 */
+	void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* out,
+		int32_t begin, int32_t end, int32_t channels, int32_t stepX) {
+		for (int32_t i = begin; i < end; i++) {
+			int32_t left = (i / channels) * 2 * channels + i % channels;
+			int32_t right = left + stepX;
+			out[i] = static_cast<uint8_t>((row0[left] + row0[right] + row1[left] + row1[right] + 2) >> 2);
+		}
+	}
+
+#ifdef MIP_GENERATOR_X86
+	/**
+	 * @brief Rounds the 2x2 averages of eight 16-bit vertical sums (four output bytes' worth).
+	 * Each pixel pair is 2 * channels lanes wide; the sum lands in the pair's first half and the
+	 * second half is left as garbage for compactSSE2 to drop.
+	 */
+	inline __m128i averagePairsSSE2(__m128i sums, int32_t channels) {
+		__m128i pairs;
+		switch (channels) {
+		case 1:
+			pairs = _mm_add_epi16(sums, _mm_srli_epi32(sums, 16));
+			break;
+		case 2:
+			pairs = _mm_add_epi16(sums, _mm_srli_epi64(sums, 32));
+			break;
+		default:
+			pairs = _mm_add_epi16(sums, _mm_srli_si128(sums, 8));
+			break;
+		}
+		return _mm_srli_epi16(_mm_add_epi16(pairs, _mm_set1_epi16(2)), 2);
+	}
+
+	/**
+	 * @brief Gathers the valid lanes of two averagePairsSSE2 results into eight 16-bit lanes.
+	 */
+	inline __m128i compactSSE2(__m128i a, __m128i b, int32_t channels) {
+		switch (channels) {
+		case 1: {
+			__m128i mask = _mm_set1_epi32(0xFFFF);
+			return _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+		}
+		case 2:
+			return _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)),
+				_mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+		default:
+			return _mm_unpacklo_epi64(a, b);
+		}
+	}
+
+	/**
+	 * @brief Produces 16 output bytes per iteration from 32 bytes of each source row. Returns
+	 * how many output bytes were written.
+	 */
+	int32_t downsampleRowSSE2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, int32_t rowBytes, int32_t channels) {
+		const __m128i zero = _mm_setzero_si128();
+		int32_t i = 0;
+		for (; i + 16 <= rowBytes; i += 16) {
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i * 2));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i * 2 + 16));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i * 2));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i * 2 + 16));
+
+			__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+			__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+			__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+			__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+			__m128i low = compactSSE2(averagePairsSSE2(s0, channels), averagePairsSSE2(s1, channels), channels);
+			__m128i high = compactSSE2(averagePairsSSE2(s2, channels), averagePairsSSE2(s3, channels), channels);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+		}
+		return i;
+	}
+
+	// The AVX2 kernel is the SSE2 one on two 128-bit lanes at once. Pixel pairs never straddle
+	// a lane, and the in-lane packs are put back in order with a 64-bit permute.
+
+	MIP_TARGET_AVX2 inline __m256i averagePairsAVX2(__m256i sums, int32_t channels) {
+		__m256i pairs;
+		switch (channels) {
+		case 1:
+			pairs = _mm256_add_epi16(sums, _mm256_srli_epi32(sums, 16));
+			break;
+		case 2:
+			pairs = _mm256_add_epi16(sums, _mm256_srli_epi64(sums, 32));
+			break;
+		default:
+			pairs = _mm256_add_epi16(sums, _mm256_srli_si256(sums, 8));
+			break;
+		}
+		return _mm256_srli_epi16(_mm256_add_epi16(pairs, _mm256_set1_epi16(2)), 2);
+	}
+
+	MIP_TARGET_AVX2 inline __m256i compactAVX2(__m256i a, __m256i b, int32_t channels) {
+		__m256i packed;
+		switch (channels) {
+		case 1: {
+			__m256i mask = _mm256_set1_epi32(0xFFFF);
+			packed = _mm256_packs_epi32(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+			break;
+		}
+		case 2:
+			packed = _mm256_unpacklo_epi64(_mm256_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)),
+				_mm256_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+			break;
+		default:
+			packed = _mm256_unpacklo_epi64(a, b);
+			break;
+		}
+		return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	MIP_TARGET_AVX2 inline __m256i loadSumsAVX2(const uint8_t* row0, const uint8_t* row1) {
+		__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)));
+		__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)));
+		return _mm256_add_epi16(a, b);
+	}
+
+	/**
+	 * @brief Produces 32 output bytes per iteration from 64 bytes of each source row. Returns
+	 * how many output bytes were written.
+	 */
+	MIP_TARGET_AVX2 int32_t downsampleRowAVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, int32_t rowBytes, int32_t channels) {
+		int32_t i = 0;
+		for (; i + 32 <= rowBytes; i += 32) {
+			const uint8_t* source0 = row0 + i * 2;
+			const uint8_t* source1 = row1 + i * 2;
+			__m256i s0 = averagePairsAVX2(loadSumsAVX2(source0, source1), channels);
+			__m256i s1 = averagePairsAVX2(loadSumsAVX2(source0 + 16, source1 + 16), channels);
+			__m256i s2 = averagePairsAVX2(loadSumsAVX2(source0 + 32, source1 + 32), channels);
+			__m256i s3 = averagePairsAVX2(loadSumsAVX2(source0 + 48, source1 + 48), channels);
+
+			__m256i low = compactAVX2(s0, s1, channels);
+			__m256i high = compactAVX2(s2, s3, channels);
+			__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+		}
+		return i;
+	}
+
+	bool cpuHasAVX2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		// The OS must save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2).
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+MipKernel bestMipKernel() {
+#ifdef MIP_GENERATOR_X86
+	static const MipKernel best = cpuHasAVX2() ? MipKernel::AVX2 : MipKernel::SSE2;
+	return best;
+#else
+	return MipKernel::Scalar;
+#endif
+}
+
+MipImage downsampleMip(const MipImage& source, MipKernel kernel) {
+	MipImage result;
+	result.width = std::max(source.width / 2, 1);
+	result.height = std::max(source.height / 2, 1);
+	result.channels = source.channels;
+	result.storage.resize(static_cast<size_t>(result.width) * result.height * result.channels);
+	result.pixels = result.storage.data();
+
+	int32_t channels = source.channels;
+	int32_t stepX = source.width > 1 ? channels : 0;
+	int32_t stepY = source.height > 1 ? 1 : 0;
+	int32_t rowBytes = result.width * channels;
+
+	// The SIMD kernels assume the right pixel of each pair is the next one, and that a pixel
+	// pair evenly divides a vector.
+	if (kernel > bestMipKernel()) {
+		kernel = bestMipKernel();
+	}
+	if (stepX == 0 || channels == 3) {
+		kernel = MipKernel::Scalar;
+	}
+
+	for (int32_t y = 0; y < result.height; y++) {
+		const uint8_t* row0 = source.pixels + static_cast<size_t>(y * 2) * source.width * channels;
+		const uint8_t* row1 = row0 + static_cast<size_t>(stepY) * source.width * channels;
+		uint8_t* out = result.storage.data() + static_cast<size_t>(y) * rowBytes;
+
+		int32_t done = 0;
+#ifdef MIP_GENERATOR_X86
+		if (kernel == MipKernel::AVX2) {
+			done = downsampleRowAVX2(row0, row1, out, rowBytes, channels);
+		}
+		if (kernel != MipKernel::Scalar) {
+			done += downsampleRowSSE2(row0 + done * 2, row1 + done * 2, out + done, rowBytes - done, channels);
+		}
+#endif
+		downsampleRowScalar(row0, row1, out, done, rowBytes, channels, stepX);
+	}
+	return result;
+}
+
+std::vector<MipImage> generateMipChain(const MipImage& source, MipKernel kernel) {
+	std::vector<MipImage> chain;
+	const MipImage* level = &source;
+	while (level->width > 1 || level->height > 1) {
+		chain.push_back(downsampleMip(*level, kernel));
+		level = &chain.back();
+	}
+	return chain;
+}
@@ -0,0 +1,74 @@
+#include "ModelRegistry.h"
+#include "AssetLoader.h"
+#include "AssimpImport.h"
+#include "TextureService.h"
+
+ModelRegistry::ModelRegistry() : m_loader(std::make_unique<AssetLoader>(ThreadPool::shared())) {
+}
+
+ModelRegistry::~ModelRegistry() = default;
+ModelRegistry::ModelRegistry(ModelRegistry&&) noexcept = default;
+ModelRegistry& ModelRegistry::operator=(ModelRegistry&&) noexcept = default;
+
+std::string ModelRegistry::makeKey(const std::string& path, bool flipTextureCoords) {
+	// The same file imported with and without flipped UVs produces different vertex data.
+	return flipTextureCoords ? path + "|flipUV" : path;
+}
+
+void ModelRegistry::addPrototype(const std::string& key, Object3D&& object) {
+	// Prototypes are never drawn or simulated, only cloned.
+	object.setMotion(Motion::Kinematic);
+	m_prototypes.emplace(key, std::move(object));
+}
+
+void ModelRegistry::request(const std::string& path, bool flipTextureCoords) {
+	auto key = makeKey(path, flipTextureCoords);
+	if (m_prototypes.count(key) == 0) {
+		m_loader->request(key, path, assimpImportFlags(flipTextureCoords));
+	}
+}
+
+void ModelRegistry::finishLoading() {
+	auto onLoaded = [this](const std::string& key, Object3D&& object) { addPrototype(key, std::move(object)); };
+	while (m_loader->hasPending()) {
+		m_loader->waitForAny(onLoaded);
+	}
+	// Upload textures that were requested alongside the models but not yet used.
+	TextureService::instance().uploadReady();
+}
+
+const Object3D& ModelRegistry::prototype(const std::string& path, bool flipTextureCoords) {
+	auto key = makeKey(path, flipTextureCoords);
+	auto existing = m_prototypes.find(key);
+	if (existing != m_prototypes.end()) {
+		return existing->second;
+	}
+
+	// A model that was requested earlier is already on its way; upload finished models until
+	// it arrives rather than importing it a second time.
+	if (m_loader->isPending(key)) {
+		auto onLoaded = [this](const std::string& loadedKey, Object3D&& object) { addPrototype(loadedKey, std::move(object)); };
+		while (m_loader->isPending(key)) {
+			m_loader->waitForAny(onLoaded);
+		}
+		existing = m_prototypes.find(key);
+		if (existing != m_prototypes.end()) {
+			return existing->second;
+		}
+	}
+
+	addPrototype(key, assimpLoad(path, flipTextureCoords));
+	return m_prototypes.at(key);
+}
+
+Object3D ModelRegistry::instantiate(const std::string& path, bool flipTextureCoords) {
+	// The clone shares the prototype's meshes and textures; only its transform and physics
+	// state are its own. Like any new object, it starts out dynamic.
+	auto object = prototype(path, flipTextureCoords).clone();
+	object.setMotion(Motion::Dynamic);
+	return object;
+}
+
+size_t ModelRegistry::size() const {
+	return m_prototypes.size();
+}
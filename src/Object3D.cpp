@@ -1,102 +1,237 @@
 #include "Object3D.h"
 #include "ShaderProgram.h"
+#include "RenderQueue.h"
+#include "TransformKernel.h"
+#include "Collision.h"
 #include <glm/ext.hpp>
+#include <algorithm>
+#include <stdexcept>
 
-glm::mat4 Object3D::buildModelMatrix() const {
-	auto m = glm::translate(glm::mat4(1), m_position);
-	m = glm::translate(m, m_center * m_scale);
-	m = glm::rotate(m, m_orientation[2], glm::vec3(0, 0, 1));
-	m = glm::rotate(m, m_orientation[0], glm::vec3(1, 0, 0));
-	m = glm::rotate(m, m_orientation[1], glm::vec3(0, 1, 0));
-	m = glm::scale(m, m_scale);
-	m = glm::translate(m, -m_center);
-	m = m * m_baseTransform;
-	return m;
+/**
+ * @brief Takes ownership of meshes that no other object shares yet.
+ */
+static std::vector<std::shared_ptr<const Mesh3D>> shareMeshes(std::vector<Mesh3D>&& meshes) {
+	std::vector<std::shared_ptr<const Mesh3D>> shared;
+	shared.reserve(meshes.size());
+	for (auto& mesh : meshes) {
+		shared.push_back(std::make_shared<const Mesh3D>(std::move(mesh)));
+	}
+	return shared;
 }
 
 Object3D::Object3D(std::vector<Mesh3D>&& meshes)
-	: Object3D(std::move(meshes), glm::mat4(1)) {
+	: Object3D(shareMeshes(std::move(meshes)), glm::mat4(1)) {
 }
 
-Object3D::Object3D(std::vector<Mesh3D>&& meshes, const glm::mat4& baseTransform)
-	: m_meshes(meshes), m_position(), m_orientation(), m_scale(1.0),
-	m_center(), m_baseTransform(baseTransform), m_material(0.1, 1.0, 0.3, 4), m_velocity(), 
-	m_acceleration(), m_rot_velocity(), m_rot_acceleration(), m_mass(1.0), m_forces()
+Object3D::Object3D(std::vector<std::shared_ptr<const Mesh3D>>&& meshes, const glm::mat4& baseTransform)
+	: m_root(World::instance().transforms.create(baseTransform))
 {
-	//add gravity because it is a universal constant
-	m_forces.push_back(GRAVITATIONAL_ACCELERATION * m_mass);
+	auto& world = World::instance();
+	Renderable renderable;
+	renderable.meshes = std::move(meshes);
+	for (auto& mesh : renderable.meshes) {
+		renderable.bounds.merge(mesh->getBounds());
+	}
+	world.renderables.insert(m_root, std::move(renderable));
+	world.bodies.insert(m_root, PhysicsBody());
+}
+
+Object3D::Object3D(Entity root) : m_root(root) {
+}
+
+Object3D::Object3D(Object3D&& other) noexcept : m_root(other.m_root) {
+	other.m_root = Entity();
+}
+
+Object3D& Object3D::operator=(Object3D&& other) noexcept {
+	if (this != &other) {
+		if (!m_root.isNull()) {
+			World::instance().destroy(m_root);
+		}
+		m_root = other.m_root;
+		other.m_root = Entity();
+	}
+	return *this;
+}
+
+Object3D::~Object3D() {
+	if (!m_root.isNull()) {
+		World::instance().destroy(m_root);
+	}
+}
+
+Object3D Object3D::clone() const {
+	return Object3D(World::instance().clone(m_root));
+}
+
+size_t Object3D::firstSlot() const {
+	return World::instance().transforms.slotOf(m_root);
+}
+
+size_t Object3D::movableSlot() const {
+	if (World::instance().statics.contains(m_root)) {
+		throw std::logic_error("Cannot move a static object; make it kinematic first");
+	}
+	return firstSlot();
+}
+
+Renderable& Object3D::renderable() const {
+	return World::instance().renderables.get(m_root);
+}
+
+PhysicsBody Object3D::body() const {
+	return World::instance().bodies.get(m_root);
 }
 
 const glm::vec3& Object3D::getPosition() const {
-	return m_position;
+	return World::instance().transforms.positionAt(firstSlot());
+}
+
+glm::vec3 Object3D::getOrientation() const {
+	return eulerFromOrientation(getRotation());
 }
 
-const glm::vec3& Object3D::getOrientation() const {
-	return m_orientation;
+const glm::quat& Object3D::getRotation() const {
+	return World::instance().transforms.orientationAt(firstSlot());
 }
 
 const glm::vec3& Object3D::getScale() const {
-	return m_scale;
+	return World::instance().transforms.scaleAt(firstSlot());
 }
 
 /**
  * @brief Gets the center of the object's rotation.
  */
 const glm::vec3& Object3D::getCenter() const {
-	return m_center;
+	return World::instance().transforms.centerAt(firstSlot());
 }
 
-const glm::vec3& Object3D::getVelocity() const {
-	return m_velocity;
+glm::vec3 Object3D::getVelocity() const {
+	return body().velocity;
 }
-const glm::vec3& Object3D::getAcceleration() const {
-	return m_acceleration;
+glm::vec3 Object3D::getAcceleration() const {
+	return body().acceleration;
 }
-const glm::vec3& Object3D::getRotationalVelocity() const {
-	return m_rot_velocity;
+glm::vec3 Object3D::getRotationalVelocity() const {
+	return body().rotVelocity;
 }
-const glm::vec3& Object3D::getRotationalAcceleration() const {
-	return m_rot_acceleration;
+glm::vec3 Object3D::getRotationalAcceleration() const {
+	return body().rotAcceleration;
 }
-const float& Object3D::getMass() const {
-	return m_mass;
+float Object3D::getMass() const {
+	return body().mass;
 }
-const std::vector<glm::vec3>& Object3D::getForces() const {
-	return m_forces;
+glm::vec3 Object3D::getForce() const {
+	return body().force;
 }
 
 
 const std::string& Object3D::getName() const {
-	return m_name;
+	return renderable().name;
 }
 
 const glm::vec4& Object3D::getMaterial() const {
-	return m_material;
+	return renderable().material;
 }
 
-size_t Object3D::numberOfChildren() const {
-	return m_children.size();
+Motion Object3D::getMotion() const {
+	auto& world = World::instance();
+	if (world.statics.contains(m_root)) {
+		return Motion::Static;
+	}
+	return world.bodies.contains(m_root) ? Motion::Dynamic : Motion::Kinematic;
+}
+
+void Object3D::setMotion(Motion motion) {
+	auto& world = World::instance();
+	auto& transforms = world.transforms;
+	auto first = firstSlot();
+	auto count = transforms.subtreeSizeAt(first);
+	for (auto slot = first; slot < first + count; slot++) {
+		auto entity = transforms.entityAt(slot);
+		if (motion != Motion::Dynamic) {
+			world.bodies.remove(entity);
+		}
+		else if (!world.bodies.contains(entity)) {
+			world.bodies.insert(entity, PhysicsBody());
+		}
+	}
+	world.statics.remove(m_root);
+	if (motion == Motion::Static) {
+		bakeStaticBounds();
+	}
+	else if (world.broadphase.contains(m_root)) {
+		world.broadphase.insert(m_root, colliderBox(world, m_root), false);
+	}
 }
 
-const Object3D& Object3D::getChild(size_t index) const {
-	return m_children[index];
+bool Object3D::isCollidable() const {
+	return World::instance().broadphase.contains(m_root);
 }
 
-Object3D& Object3D::getChild(size_t index) {
-	return m_children[index];
+void Object3D::setCollidable(bool collidable) {
+	auto& world = World::instance();
+	if (collidable) {
+		world.broadphase.insert(m_root, colliderBox(world, m_root), world.statics.contains(m_root));
+	}
+	else {
+		world.broadphase.remove(m_root);
+	}
+}
+
+void Object3D::bakeStaticBounds() {
+	auto& world = World::instance();
+	// Bring the world matrices up to date; the root's is final from here on.
+	world.transforms.updateWorld();
+	auto& bounds = renderable().bounds;
+	auto sphere = bounds.isEmpty() ? BoundingSphere{ glm::vec3(0), 0 } : bounds.sphere(world.transforms.worldAt(firstSlot()));
+	world.statics.insert(m_root, StaticBounds{ sphere });
+	// The collider's box, too, is never recomputed.
+	if (world.broadphase.contains(m_root)) {
+		world.broadphase.insert(m_root, colliderBox(world, m_root), true);
+	}
+}
+
+Entity Object3D::getEntity() const {
+	return m_root;
+}
+
+size_t Object3D::numberOfChildren() const {
+	auto& transforms = World::instance().transforms;
+	auto first = firstSlot();
+	auto end = first + transforms.subtreeSizeAt(first);
+	size_t count = 0;
+	// The root's children are the nodes reached by skipping from one subtree to the next.
+	for (auto slot = first + 1; slot < end; slot += transforms.subtreeSizeAt(slot)) {
+		count++;
+	}
+	return count;
+}
+
+Entity Object3D::getChild(size_t index) const {
+	auto& transforms = World::instance().transforms;
+	auto slot = firstSlot() + 1;
+	for (size_t i = 0; i < index; i++) {
+		slot += transforms.subtreeSizeAt(slot);
+	}
+	return transforms.entityAt(slot);
 }
 
 
 void Object3D::setPosition(const glm::vec3& position) {
-	m_position = position;
+	World::instance().transforms.setPositionAt(movableSlot(), position);
 }
 
 void Object3D::setOrientation(const glm::vec3& orientation) {
-	m_orientation = orientation;
+	setRotation(orientationFromEuler(orientation));
+}
+
+void Object3D::setRotation(const glm::quat& rotation) {
+	World::instance().transforms.setOrientationAt(movableSlot(), glm::normalize(rotation));
 }
 
 void Object3D::setScale(const glm::vec3& scale) {
-	m_scale = scale;
+	World::instance().transforms.setScaleAt(movableSlot(), scale);
 }
 
 /**
@@ -105,41 +240,40 @@ void Object3D::setScale(const glm::vec3& scale) {
  */
 void Object3D::setCenter(const glm::vec3& center)
 {
-	m_center = center;
+	World::instance().transforms.setCenterAt(movableSlot(), center);
 }
 
 void Object3D::setName(const std::string& name) {
-	m_name = name;
+	renderable().name = name;
 }
 
 void Object3D::setMaterial(const glm::vec4& material) {
-	m_material = material;
+	renderable().material = material;
 }
 
 void Object3D::setVelocity(const glm::vec3& velocity) {
-	m_velocity = velocity;
+	World::instance().bodies.setVelocity(m_root, velocity);
 }
 
 void Object3D::setAcceleration(const glm::vec3& acceleration) {
-	m_acceleration = acceleration;
+	World::instance().bodies.setAcceleration(m_root, acceleration);
 }
 
 void Object3D::setRotationalVelocity(const glm::vec3& rotVelocity) {
-	m_rot_velocity = rotVelocity;
+	World::instance().bodies.setRotationalVelocity(m_root, rotVelocity);
 }
 
 void Object3D::setRotationalAcceleration(const glm::vec3& rotAcceleration) {
-	m_rot_acceleration = rotAcceleration;
+	World::instance().bodies.setRotationalAcceleration(m_root, rotAcceleration);
 }
 
 void Object3D::setMass(const float& mass) {
-	m_mass = mass;
 	//since we changed the mass, we must update the acceleration due to gravity
-	clearForces();
+	World::instance().bodies.setMass(m_root, mass);
 }
 
 void Object3D::addForce(const glm::vec3& force) {
-	m_forces.push_back(force);
+	World::instance().bodies.addForce(m_root, force);
 }
 
 // I forgot that c++ removal of elements in vectors needs iterators,
@@ -147,94 +281,194 @@ void Object3D::addForce(const glm::vec3& force) {
 // simpler. Here is the Geeks for Geeks link I double checked my work with even though 
 // I didn't really need it lol: https://www.geeksforgeeks.org/vector-erase-and-clear-in-cpp/
 void Object3D::clearForces() {
-	m_forces.clear();
-	//add gravity back because it is a constant force
-	m_forces.push_back(GRAVITATIONAL_ACCELERATION * m_mass);
-}
-
-void Object3D::tick(float dt) {
-	if (m_position.y == 0) {
-		//Add mu : frictional contant of a surface; negative gravity so no need to flip sign
-		float muX = std::abs(GRAVITATIONAL_ACCELERATION.y * MU);
-		float muZ = std::abs(GRAVITATIONAL_ACCELERATION.y * MU);
-		glm::vec3 direction = glm::normalize(glm::vec3(m_velocity.x, 0, m_velocity.z));
-		float xSign = (m_velocity.x < 0.0) ? 1.0 : -1.0;
-		float zSign = (m_velocity.z < 0.0) ? 1.0 : -1.0;
-	
-
-		addForce(glm::vec3(std::abs(direction.x) * xSign * muX * m_mass, 0, std::abs(direction.z) * zSign * muZ * m_mass));
-
-		//if the object has stopped horizontally, we no longer want to apply friction
-		if (m_velocity.x == 0)
-			clearForces();
-
-		// finally, apply the normal force against gravity
-		addForce(-GRAVITATIONAL_ACCELERATION * m_mass);
-	}
-	// add up all the forces to get the new acceleration (boy do I miss kinematic physics)
-	// update the frictional forces 	
-	glm::vec3 netForce(0, 0, 0);
-	for (glm::vec3& f : m_forces)
-		netForce += f;
-
-	//yes; in Michael physics mass can equal 0. So we must account for that.
-	if(m_mass > 0)
-		m_acceleration = netForce / m_mass;
-
-	//now clear the forces
-	clearForces();
-	//we will make it so that the y coordinate of an object never dips below 0
-	if (m_position.y < 0 && m_mass != 0)
-		m_position = glm::vec3(m_position.x, 0, m_position.z);
-
-	// rebuild the matrix with updated position
-	m_velocity += m_acceleration * dt;
-	m_position += m_velocity * dt;
-	//prevent studdering. This could be fixed in the future with collisions.
-	if (m_position.y < 0)
-		m_position.y = 0;
-	buildModelMatrix();
-		
-	//apply to any children
-	for (auto& c : m_children) {
-		c.tick(dt);
-	}
+	World::instance().bodies.clearForces(m_root);
 }
 
 void Object3D::move(const glm::vec3& offset) {
-	m_position = m_position + offset;
+	auto& transforms = World::instance().transforms;
+	auto slot = movableSlot();
+	transforms.setPositionAt(slot, transforms.positionAt(slot) + offset);
 }
 
 void Object3D::rotate(const glm::vec3& rotation) {
-	m_orientation = m_orientation + rotation;
+	rotate(orientationFromEuler(rotation));
+}
+
+void Object3D::rotate(const glm::quat& rotation) {
+	// setRotation normalizes, which keeps rounding from building up over many small turns.
+	setRotation(getRotation() * rotation);
 }
 
 void Object3D::grow(const glm::vec3& growth) {
-	m_scale = m_scale * growth;
+	auto& transforms = World::instance().transforms;
+	auto slot = movableSlot();
+	transforms.setScaleAt(slot, transforms.scaleAt(slot) * growth);
 }
 
 void Object3D::addChild(Object3D&& child) {
-	m_children.emplace_back(child);
+	auto& world = World::instance();
+	if (world.statics.contains(m_root) || world.statics.contains(child.m_root)) {
+		throw std::logic_error("Cannot attach a static object, or attach to one");
+	}
+	world.transforms.attach(m_root, child.m_root);
+	renderable().bounds.merge(boundsInParent(child.m_root));
+	child.m_root = Entity();
+}
+
+const Aabb& Object3D::getBounds() const {
+	return renderable().bounds;
+}
+
+void Object3D::updateBounds() {
+	auto& world = World::instance();
+	auto& transforms = world.transforms;
+	auto first = firstSlot();
+	auto count = transforms.subtreeSizeAt(first);
+	for (auto slot = first; slot < first + count; slot++) {
+		auto& node = world.renderables.get(transforms.entityAt(slot));
+		node.bounds = Aabb();
+		for (auto& mesh : node.meshes) {
+			node.bounds.merge(mesh->getBounds());
+		}
+	}
+	// Children come after their parents, so walking backwards finishes each node's bounds
+	// before merging them into its parent's.
+	for (auto slot = first + count - 1; slot > first; slot--) {
+		auto parent = transforms.entityAt(transforms.parentAt(slot));
+		world.renderables.get(parent).bounds.merge(boundsInParent(transforms.entityAt(slot)));
+	}
+	if (world.statics.contains(m_root)) {
+		bakeStaticBounds();
+	}
+}
+
+/**
+ * @brief The local matrix rotates around the point position + center * scale, so the bounds
+ * are turned into a sphere around that point, which no orientation can move geometry out of.
+ */
+Aabb Object3D::boundsInParent(Entity node) const {
+	Aabb result;
+	auto& world = World::instance();
+	auto& bounds = world.renderables.get(node).bounds;
+	if (bounds.isEmpty()) {
+		return result;
+	}
+	auto& transforms = world.transforms;
+	auto slot = transforms.slotOf(node);
+	auto& scale = transforms.scaleAt(slot);
+	auto& center = transforms.centerAt(slot);
+	auto unrotated = glm::scale(glm::mat4(1), scale) * glm::translate(glm::mat4(1), -center) * transforms.baseTransformAt(slot);
+	auto corners = bounds.transformed(unrotated);
+	float radius = glm::length(glm::max(glm::abs(corners.min), glm::abs(corners.max)));
+	auto pivot = transforms.positionAt(slot) + center * scale;
+	result.merge(pivot - glm::vec3(radius));
+	result.merge(pivot + glm::vec3(radius));
+	return result;
 }
 
 void Object3D::render(ShaderProgram& shaderProgram) const {
-	renderRecursive(shaderProgram, glm::mat4(1));
+	auto& world = World::instance();
+	auto& transforms = world.transforms;
+	auto first = firstSlot();
+	auto count = transforms.subtreeSizeAt(first);
+	for (auto slot = first; slot < first + count; slot++) {
+		shaderProgram.setUniform("model", transforms.worldAt(slot));
+		for (auto& mesh : world.renderables.get(transforms.entityAt(slot)).meshes) {
+			mesh->render(shaderProgram);
+		}
+	}
+}
+
+void Object3D::submit(RenderQueue& queue) const {
+	auto& world = World::instance();
+	auto& transforms = world.transforms;
+	auto first = firstSlot();
+	auto count = transforms.subtreeSizeAt(first);
+	for (auto slot = first; slot < first + count; slot++) {
+		for (auto& mesh : world.renderables.get(transforms.entityAt(slot)).meshes) {
+			queue.add(*mesh, transforms.worldAt(slot));
+		}
+	}
+}
+
+void Object3D::submitVisible(const std::vector<Object3D>& objects, RenderQueue& queue,
+	const Frustum& frustum, CullingStats& stats) {
+	// Test every top-level object's sphere in one SIMD pass, then descend only into the ones
+	// that are not entirely outside. The scratch arrays are reused across frames; rendering only
+	// happens on the GL thread.
+	static std::vector<float> x, y, z, radius;
+	static std::vector<Containment> results;
+	x.resize(objects.size());
+	y.resize(objects.size());
+	z.resize(objects.size());
+	radius.resize(objects.size());
+	results.resize(objects.size());
+
+	auto& world = World::instance();
+	for (size_t i = 0; i < objects.size(); i++) {
+		// Static scenery's sphere was baked when it was placed.
+		auto baked = world.statics.find(objects[i].m_root);
+		auto& bounds = objects[i].renderable().bounds;
+		auto sphere = baked ? baked->sphere
+			: bounds.isEmpty() ? BoundingSphere{ glm::vec3(0), 0 } : bounds.sphere(world.transforms.worldAt(objects[i].firstSlot()));
+		x[i] = sphere.center.x;
+		y[i] = sphere.center.y;
+		z[i] = sphere.center.z;
+		radius[i] = sphere.radius;
+	}
+	frustum.classify(x.data(), y.data(), z.data(), radius.data(), objects.size(), results.data());
+
+	for (size_t i = 0; i < objects.size(); i++) {
+		// An object with nothing to draw is never visible.
+		auto containment = objects[i].renderable().bounds.isEmpty() ? Containment::Outside : results[i];
+		objects[i].submitContained(queue, containment, frustum, stats);
+	}
 }
 
 /**
- * @brief Renders the object and its children, recursively.
- * @param parentMatrix the model matrix of this object's parent in the model hierarchy.
+ * @brief Walks the hierarchy in the store's order, given the root's containment. A node outside
+ * the frustum skips its whole subtree; below a node entirely inside, nothing is tested.
  */
-void Object3D::renderRecursive(ShaderProgram& shaderProgram, const glm::mat4& parentMatrix) const {
-	// This object's true model matrix is the combination of its parent's matrix and the object's matrix.
-	glm::mat4 trueModel = parentMatrix * buildModelMatrix();
-	shaderProgram.setUniform("model", trueModel);
-	// Render each mesh in the object.
-	for (auto& mesh : m_meshes) {
-		mesh.render(shaderProgram);
-	}
-	// Render the children of the object.
-	for (auto& child : m_children) {
-		child.renderRecursive(shaderProgram, trueModel);
+void Object3D::submitContained(RenderQueue& queue, Containment containment, const Frustum& frustum,
+	CullingStats& stats) const {
+	auto& world = World::instance();
+	auto& transforms = world.transforms;
+	auto first = firstSlot();
+	auto end = first + transforms.subtreeSizeAt(first);
+	// Slots before this one are descendants of a node entirely inside the frustum.
+	size_t insideEnd = 0;
+	auto slot = first;
+	while (slot < end) {
+		auto& node = world.renderables.get(transforms.entityAt(slot));
+		auto& worldMatrix = transforms.worldAt(slot);
+		size_t subtreeSize = transforms.subtreeSizeAt(slot);
+		if (slot > first) {
+			if (node.bounds.isEmpty()) {
+				containment = Containment::Outside;
+			}
+			else if (slot < insideEnd) {
+				containment = Containment::Inside;
+			}
+			else {
+				containment = frustum.classify(node.bounds.sphere(worldMatrix));
+			}
+		}
+		if (containment == Containment::Outside) {
+			stats.culled += subtreeSize;
+			slot += subtreeSize;
+			continue;
+		}
+		stats.visible++;
+
+		if (containment == Containment::Inside) {
+			insideEnd = std::max(insideEnd, slot + subtreeSize);
+		}
+		for (auto& mesh : node.meshes) {
+			if (containment == Containment::Inside || node.meshes.size() == 1
+				|| frustum.classify(transformSphere(mesh->getBoundingSphere(), worldMatrix)) != Containment::Outside) {
+				queue.add(*mesh, worldMatrix);
+			}
+		}
+		slot++;
 	}
 }
@@ -0,0 +1,232 @@
+#include "Physics.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC emits AVX intrinsics without any per-function opt-in.
+#define PHYSICS_TARGET_AVX
+#else
+#define PHYSICS_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace {
+	//Add mu : frictional contant of a surface; negative gravity so no need to flip sign
+	const float FRICTION = std::abs(PhysicsBody::GRAVITATIONAL_ACCELERATION.y * PhysicsBody::MU);
+
+	/**
+	 * @brief Integrates bodies [begin, count). Also the reference the AVX kernel must match bit
+	 * for bit, so both evaluate every expression in the same order.
+	 */
+	void integrateScalar(const BodyColumns& bodies, size_t begin, float dt) {
+		const auto GRAVITATIONAL_ACCELERATION = PhysicsBody::GRAVITATIONAL_ACCELERATION;
+		for (size_t i = begin; i < bodies.count; i++) {
+			float mass = bodies.mass[i];
+			float x = bodies.positionX[i], y = bodies.positionY[i], z = bodies.positionZ[i];
+			float vx = bodies.velocityX[i], vy = bodies.velocityY[i], vz = bodies.velocityZ[i];
+			float fx = bodies.forceX[i], fy = bodies.forceY[i], fz = bodies.forceZ[i];
+			auto weight = GRAVITATIONAL_ACCELERATION * mass;
+			if (y == 0) {
+				//if the object has stopped horizontally, we no longer want to apply friction
+				if (vx == 0) {
+					fx = weight.x;
+					fy = weight.y;
+					fz = weight.z;
+				}
+				else {
+					// Friction opposes the horizontal direction of travel.
+					float inverseLength = 1 / std::sqrt(vx * vx + vz * vz);
+					float xSign = vx < 0 ? 1.0f : -1.0f;
+					float zSign = vz < 0 ? 1.0f : -1.0f;
+					fx += std::abs(vx * inverseLength) * xSign * FRICTION * mass;
+					fz += std::abs(vz * inverseLength) * zSign * FRICTION * mass;
+				}
+				// finally, apply the normal force against gravity
+				fx += -GRAVITATIONAL_ACCELERATION.x * mass;
+				fy += -GRAVITATIONAL_ACCELERATION.y * mass;
+				fz += -GRAVITATIONAL_ACCELERATION.z * mass;
+			}
+			//yes; in Michael physics mass can equal 0. So we must account for that.
+			if (mass > 0) {
+				bodies.accelerationX[i] = fx / mass;
+				bodies.accelerationY[i] = fy / mass;
+				bodies.accelerationZ[i] = fz / mass;
+			}
+			//now clear the forces
+			bodies.forceX[i] = weight.x;
+			bodies.forceY[i] = weight.y;
+			bodies.forceZ[i] = weight.z;
+			//we will make it so that the y coordinate of an object never dips below 0
+			if (y < 0 && mass != 0) {
+				y = 0;
+			}
+
+			vx += bodies.accelerationX[i] * dt;
+			vy += bodies.accelerationY[i] * dt;
+			vz += bodies.accelerationZ[i] * dt;
+			x += vx * dt;
+			y += vy * dt;
+			z += vz * dt;
+			//prevent studdering. This could be fixed in the future with collisions.
+			if (y < 0) {
+				y = 0;
+			}
+			bodies.velocityX[i] = vx;
+			bodies.velocityY[i] = vy;
+			bodies.velocityZ[i] = vz;
+			bodies.positionX[i] = x;
+			bodies.positionY[i] = y;
+			bodies.positionZ[i] = z;
+		}
+	}
+
+#ifdef PHYSICS_X86
+	/**
+	 * @brief Picks b in the lanes where the mask is set and a elsewhere. The same as
+	 * _mm256_blendv_ps, which GCC turns into scalar code when only AVX, not AVX2, is enabled.
+	 */
+	PHYSICS_TARGET_AVX inline __m256 select(__m256 a, __m256 b, __m256 mask) {
+		return _mm256_or_ps(_mm256_and_ps(mask, b), _mm256_andnot_ps(mask, a));
+	}
+
+	/**
+	 * @brief Integrates eight bodies per iteration, evaluating both sides of every branch and
+	 * selecting by the scalar kernel's conditions. Returns how many bodies were integrated.
+	 */
+	PHYSICS_TARGET_AVX size_t integrateAVX(const BodyColumns& bodies, float dt) {
+		const auto GRAVITATIONAL_ACCELERATION = PhysicsBody::GRAVITATIONAL_ACCELERATION;
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256 minusOne = _mm256_set1_ps(-1);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		const __m256 friction = _mm256_set1_ps(FRICTION);
+		const __m256 step = _mm256_set1_ps(dt);
+		const __m256 gravityX = _mm256_set1_ps(GRAVITATIONAL_ACCELERATION.x);
+		const __m256 gravityY = _mm256_set1_ps(GRAVITATIONAL_ACCELERATION.y);
+		const __m256 gravityZ = _mm256_set1_ps(GRAVITATIONAL_ACCELERATION.z);
+		const __m256 normalX = _mm256_set1_ps(-GRAVITATIONAL_ACCELERATION.x);
+		const __m256 normalY = _mm256_set1_ps(-GRAVITATIONAL_ACCELERATION.y);
+		const __m256 normalZ = _mm256_set1_ps(-GRAVITATIONAL_ACCELERATION.z);
+
+		size_t i = 0;
+		for (; i + 8 <= bodies.count; i += 8) {
+			__m256 mass = _mm256_loadu_ps(bodies.mass + i);
+			__m256 x = _mm256_loadu_ps(bodies.positionX + i);
+			__m256 y = _mm256_loadu_ps(bodies.positionY + i);
+			__m256 z = _mm256_loadu_ps(bodies.positionZ + i);
+			__m256 vx = _mm256_loadu_ps(bodies.velocityX + i);
+			__m256 vy = _mm256_loadu_ps(bodies.velocityY + i);
+			__m256 vz = _mm256_loadu_ps(bodies.velocityZ + i);
+			__m256 fx = _mm256_loadu_ps(bodies.forceX + i);
+			__m256 fy = _mm256_loadu_ps(bodies.forceY + i);
+			__m256 fz = _mm256_loadu_ps(bodies.forceZ + i);
+			__m256 weightX = _mm256_mul_ps(gravityX, mass);
+			__m256 weightY = _mm256_mul_ps(gravityY, mass);
+			__m256 weightZ = _mm256_mul_ps(gravityZ, mass);
+
+			// Friction; lanes that have stopped along x, where it is garbage, get their weight instead.
+			__m256 onGround = _mm256_cmp_ps(y, zero, _CMP_EQ_OQ);
+			__m256 stopped = _mm256_cmp_ps(vx, zero, _CMP_EQ_OQ);
+			__m256 inverseLength = _mm256_div_ps(one,
+				_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vz, vz))));
+			__m256 xSign = select(minusOne, one, _mm256_cmp_ps(vx, zero, _CMP_LT_OQ));
+			__m256 zSign = select(minusOne, one, _mm256_cmp_ps(vz, zero, _CMP_LT_OQ));
+			__m256 frictionX = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(
+				_mm256_andnot_ps(signBit, _mm256_mul_ps(vx, inverseLength)), xSign), friction), mass);
+			__m256 frictionZ = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(
+				_mm256_andnot_ps(signBit, _mm256_mul_ps(vz, inverseLength)), zSign), friction), mass);
+			__m256 groundX = select(_mm256_add_ps(fx, frictionX), weightX, stopped);
+			__m256 groundY = select(fy, weightY, stopped);
+			__m256 groundZ = select(_mm256_add_ps(fz, frictionZ), weightZ, stopped);
+			// The normal force against gravity.
+			groundX = _mm256_add_ps(groundX, _mm256_mul_ps(normalX, mass));
+			groundY = _mm256_add_ps(groundY, _mm256_mul_ps(normalY, mass));
+			groundZ = _mm256_add_ps(groundZ, _mm256_mul_ps(normalZ, mass));
+			fx = select(fx, groundX, onGround);
+			fy = select(fy, groundY, onGround);
+			fz = select(fz, groundZ, onGround);
+
+			// Massless bodies keep their acceleration.
+			__m256 massive = _mm256_cmp_ps(mass, zero, _CMP_GT_OQ);
+			__m256 ax = select(_mm256_loadu_ps(bodies.accelerationX + i), _mm256_div_ps(fx, mass), massive);
+			__m256 ay = select(_mm256_loadu_ps(bodies.accelerationY + i), _mm256_div_ps(fy, mass), massive);
+			__m256 az = select(_mm256_loadu_ps(bodies.accelerationZ + i), _mm256_div_ps(fz, mass), massive);
+			_mm256_storeu_ps(bodies.accelerationX + i, ax);
+			_mm256_storeu_ps(bodies.accelerationY + i, ay);
+			_mm256_storeu_ps(bodies.accelerationZ + i, az);
+			_mm256_storeu_ps(bodies.forceX + i, weightX);
+			_mm256_storeu_ps(bodies.forceY + i, weightY);
+			_mm256_storeu_ps(bodies.forceZ + i, weightZ);
+
+			__m256 sunk = _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), _mm256_cmp_ps(mass, zero, _CMP_NEQ_UQ));
+			y = select(y, zero, sunk);
+
+			vx = _mm256_add_ps(vx, _mm256_mul_ps(ax, step));
+			vy = _mm256_add_ps(vy, _mm256_mul_ps(ay, step));
+			vz = _mm256_add_ps(vz, _mm256_mul_ps(az, step));
+			x = _mm256_add_ps(x, _mm256_mul_ps(vx, step));
+			y = _mm256_add_ps(y, _mm256_mul_ps(vy, step));
+			z = _mm256_add_ps(z, _mm256_mul_ps(vz, step));
+			y = select(y, zero, _mm256_cmp_ps(y, zero, _CMP_LT_OQ));
+			_mm256_storeu_ps(bodies.velocityX + i, vx);
+			_mm256_storeu_ps(bodies.velocityY + i, vy);
+			_mm256_storeu_ps(bodies.velocityZ + i, vz);
+			_mm256_storeu_ps(bodies.positionX + i, x);
+			_mm256_storeu_ps(bodies.positionY + i, y);
+			_mm256_storeu_ps(bodies.positionZ + i, z);
+		}
+		return i;
+	}
+
+	bool cpuHasAVX() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		// The OS must save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2).
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		return osSavesYmm && (info[2] & (1 << 28)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+#endif
+}
+
+PhysicsKernel bestPhysicsKernel() {
+#ifdef PHYSICS_X86
+	static const PhysicsKernel best = cpuHasAVX() ? PhysicsKernel::AVX : PhysicsKernel::Scalar;
+	return best;
+#else
+	return PhysicsKernel::Scalar;
+#endif
+}
+
+void integrateBodies(PhysicsBodies& bodies, float dt, PhysicsKernel kernel) {
+	auto columns = bodies.columns();
+	size_t done = 0;
+#ifdef PHYSICS_X86
+	if (kernel == PhysicsKernel::AVX && bestPhysicsKernel() == PhysicsKernel::AVX) {
+		done = integrateAVX(columns, dt);
+	}
+#endif
+	integrateScalar(columns, done, dt);
+}
+
+void tickPhysics(World& world, float dt) {
+	auto& transforms = world.transforms;
+	auto& bodies = world.bodies;
+	auto& entities = bodies.entities();
+	for (size_t i = 0; i < entities.size(); i++) {
+		bodies.setPositionAt(i, transforms.positionAt(transforms.slotOf(entities[i])));
+	}
+	integrateBodies(bodies, dt);
+	// The store only marks a node dirty if its position really changed, which for a body at
+	// rest it never does.
+	for (size_t i = 0; i < entities.size(); i++) {
+		transforms.setPositionAt(transforms.slotOf(entities[i]), bodies.positionAt(i));
+	}
+}
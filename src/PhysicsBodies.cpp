@@ -0,0 +1,125 @@
+#include "PhysicsBodies.h"
+#include <stdexcept>
+
+uint32_t PhysicsBodies::positionOf(Entity entity) const {
+	if (entity.index >= m_sparse.size()) {
+		return ABSENT;
+	}
+	auto position = m_sparse[entity.index];
+	// A stale handle whose index has been reused by another entity.
+	if (position != ABSENT && m_entities[position] != entity) {
+		return ABSENT;
+	}
+	return position;
+}
+
+size_t PhysicsBodies::at(Entity entity) const {
+	auto position = positionOf(entity);
+	if (position == ABSENT) {
+		throw std::out_of_range("Entity has no physics body");
+	}
+	return position;
+}
+
+void PhysicsBodies::insert(Entity entity, const PhysicsBody& body) {
+	auto position = positionOf(entity);
+	if (position == ABSENT) {
+		if (entity.index >= m_sparse.size()) {
+			m_sparse.resize(entity.index + 1, ABSENT);
+		}
+		position = static_cast<uint32_t>(m_entities.size());
+		m_sparse[entity.index] = position;
+		forEachColumn([](auto& column) { column.emplace_back(); });
+		m_entities[position] = entity;
+	}
+	m_velocityX[position] = body.velocity.x;
+	m_velocityY[position] = body.velocity.y;
+	m_velocityZ[position] = body.velocity.z;
+	m_accelerationX[position] = body.acceleration.x;
+	m_accelerationY[position] = body.acceleration.y;
+	m_accelerationZ[position] = body.acceleration.z;
+	m_forceX[position] = body.force.x;
+	m_forceY[position] = body.force.y;
+	m_forceZ[position] = body.force.z;
+	m_mass[position] = body.mass;
+	m_rotVelocities[position] = body.rotVelocity;
+	m_rotAccelerations[position] = body.rotAcceleration;
+}
+
+void PhysicsBodies::remove(Entity entity) {
+	auto position = positionOf(entity);
+	if (position == ABSENT) {
+		return;
+	}
+	auto last = m_entities.size() - 1;
+	if (position != last) {
+		forEachColumn([&](auto& column) { column[position] = column[last]; });
+		m_sparse[m_entities[position].index] = position;
+	}
+	forEachColumn([](auto& column) { column.pop_back(); });
+	m_sparse[entity.index] = ABSENT;
+}
+
+PhysicsBody PhysicsBodies::get(Entity entity) const {
+	auto i = at(entity);
+	PhysicsBody body;
+	body.velocity = glm::vec3(m_velocityX[i], m_velocityY[i], m_velocityZ[i]);
+	body.acceleration = glm::vec3(m_accelerationX[i], m_accelerationY[i], m_accelerationZ[i]);
+	body.rotVelocity = m_rotVelocities[i];
+	body.rotAcceleration = m_rotAccelerations[i];
+	body.mass = m_mass[i];
+	body.force = glm::vec3(m_forceX[i], m_forceY[i], m_forceZ[i]);
+	return body;
+}
+
+void PhysicsBodies::setVelocity(Entity entity, const glm::vec3& velocity) {
+	auto i = at(entity);
+	m_velocityX[i] = velocity.x;
+	m_velocityY[i] = velocity.y;
+	m_velocityZ[i] = velocity.z;
+}
+
+void PhysicsBodies::setAcceleration(Entity entity, const glm::vec3& acceleration) {
+	auto i = at(entity);
+	m_accelerationX[i] = acceleration.x;
+	m_accelerationY[i] = acceleration.y;
+	m_accelerationZ[i] = acceleration.z;
+}
+
+void PhysicsBodies::setRotationalVelocity(Entity entity, const glm::vec3& rotVelocity) {
+	m_rotVelocities[at(entity)] = rotVelocity;
+}
+
+void PhysicsBodies::setRotationalAcceleration(Entity entity, const glm::vec3& rotAcceleration) {
+	m_rotAccelerations[at(entity)] = rotAcceleration;
+}
+
+void PhysicsBodies::setMass(Entity entity, float mass) {
+	m_mass[at(entity)] = mass;
+	clearForces(entity);
+}
+
+void PhysicsBodies::addForce(Entity entity, const glm::vec3& force) {
+	auto i = at(entity);
+	m_forceX[i] += force.x;
+	m_forceY[i] += force.y;
+	m_forceZ[i] += force.z;
+}
+
+void PhysicsBodies::clearForces(Entity entity) {
+	auto i = at(entity);
+	auto weight = PhysicsBody::GRAVITATIONAL_ACCELERATION * m_mass[i];
+	m_forceX[i] = weight.x;
+	m_forceY[i] = weight.y;
+	m_forceZ[i] = weight.z;
+}
+
+BodyColumns PhysicsBodies::columns() {
+	return BodyColumns{
+		m_positionX.data(), m_positionY.data(), m_positionZ.data(),
+		m_velocityX.data(), m_velocityY.data(), m_velocityZ.data(),
+		m_accelerationX.data(), m_accelerationY.data(), m_accelerationZ.data(),
+		m_forceX.data(), m_forceY.data(), m_forceZ.data(),
+		m_mass.data(), m_entities.size()
+	};
+}
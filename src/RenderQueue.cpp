@@ -0,0 +1,162 @@
+#include "RenderQueue.h"
+#include "Hash.h"
+#include "GLState.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <stdexcept>
+
+RenderQueue::RenderQueue()
+	: m_instanceBuffer(0), m_capacity(0), m_currentProgram(0), m_viewer(0), m_maxDistance(1) {
+	glGenBuffers(1, &m_instanceBuffer);
+}
+
+RenderQueue::~RenderQueue() {
+	GLState::instance().deleteBuffer(m_instanceBuffer);
+}
+
+void RenderQueue::setProgram(ShaderProgram& program) {
+	auto it = std::find(m_programs.begin(), m_programs.end(), &program);
+	if (it == m_programs.end()) {
+		if (m_programs.size() == (size_t(1) << PROGRAM_BITS)) {
+			throw std::length_error("Too many shader programs in one render queue");
+		}
+		it = m_programs.insert(m_programs.end(), &program);
+	}
+	m_currentProgram = static_cast<uint32_t>(it - m_programs.begin());
+}
+
+void RenderQueue::setViewer(const glm::vec3& position, float maxDistance) {
+	m_viewer = position;
+	m_maxDistance = maxDistance;
+}
+
+uint32_t RenderQueue::materialOf(const Mesh3D& mesh) {
+	// Number texture sets rather than meshes: the parts of a model often share one.
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for (auto& texture : mesh.getTextures()) {
+		auto textureId = texture.texture->getId();
+		hash = fnv1a(&textureId, sizeof(textureId), hash);
+		hash = fnv1a(texture.samplerName, hash);
+	}
+	auto [it, inserted] = m_materials.try_emplace(hash, static_cast<uint32_t>(m_materials.size()));
+	return it->second;
+}
+
+void RenderQueue::add(const Mesh3D& mesh, const glm::mat4& model) {
+	if (m_programs.empty()) {
+		throw std::logic_error("RenderQueue::setProgram must be called before add");
+	}
+	auto material = materialOf(mesh);
+
+	// Distance from the viewer to the mesh's center, quantized to the low bits of the key.
+	auto center = glm::vec3(model * glm::vec4(mesh.getBoundingSphere().center, 1));
+	float distance = std::min(glm::distance(center, m_viewer) / m_maxDistance, 1.0f);
+	auto depth = static_cast<uint64_t>(distance * ((1 << DEPTH_BITS) - 1));
+
+	uint64_t key = uint64_t(m_currentProgram) << (MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS);
+	key |= uint64_t(material & ((1 << MATERIAL_BITS) - 1)) << (VERTEX_ARRAY_BITS + DEPTH_BITS);
+	key |= uint64_t(mesh.getVao() & ((1 << VERTEX_ARRAY_BITS) - 1)) << DEPTH_BITS;
+	key |= depth;
+
+	m_keys.push_back(SortEntry{ key, static_cast<uint32_t>(m_items.size()) });
+	m_items.push_back(DrawItem{ &mesh, m_currentProgram, material });
+	m_instances.push_back(InstanceData{ model, glm::mat3(glm::transpose(glm::inverse(model))) });
+}
+
+void RenderQueue::radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) {
+	scratch.resize(entries.size());
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = {};
+		for (auto& entry : entries) {
+			counts[(entry.key >> shift) & 0xFF]++;
+		}
+		// Every key has the same byte here; this pass would not move anything.
+		if (counts[(entries[0].key >> shift) & 0xFF] == entries.size()) {
+			continue;
+		}
+		size_t offset = 0;
+		for (auto& count : counts) {
+			auto start = offset;
+			offset += count;
+			count = start;
+		}
+		for (auto& entry : entries) {
+			scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+		entries.swap(scratch);
+	}
+}
+
+void RenderQueue::bindInstanceAttributes(size_t firstInstance) const {
+	auto base = firstInstance * sizeof(InstanceData);
+	auto location = FIRST_INSTANCE_ATTRIBUTE;
+	// A mat4 attribute takes four vec4 locations, and a mat3 three vec3 ones.
+	for (uint32_t column = 0; column < 4; column++, location++) {
+		glVertexAttribPointer(location, 4, GL_FLOAT, false, sizeof(InstanceData),
+			reinterpret_cast<void*>(base + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+	for (uint32_t column = 0; column < 3; column++, location++) {
+		glVertexAttribPointer(location, 3, GL_FLOAT, false, sizeof(InstanceData),
+			reinterpret_cast<void*>(base + offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+}
+
+size_t RenderQueue::render() {
+	if (m_items.empty()) {
+		return 0;
+	}
+	radixSort(m_keys, m_sortScratch);
+
+	// Lay the instances out in sorted order, so each batch's are contiguous and the whole frame
+	// is one buffer upload.
+	m_staging.clear();
+	for (auto& entry : m_keys) {
+		m_staging.push_back(m_instances[entry.item]);
+	}
+
+	auto& state = GLState::instance();
+	state.bindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_staging.size() > m_capacity) {
+		m_capacity = m_staging.size() * 2;
+	}
+	// Orphan last frame's storage so the driver does not wait for draws still reading it.
+	glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_staging.size() * sizeof(InstanceData), m_staging.data());
+
+	size_t drawCalls = 0;
+	size_t first = 0;
+	while (first < m_keys.size()) {
+		// A batch is a run of items with the same program, textures and vertex array. The key
+		// holds truncated IDs, so compare the items themselves.
+		auto& item = m_items[m_keys[first].item];
+		size_t end = first + 1;
+		while (end < m_keys.size()) {
+			auto& next = m_items[m_keys[end].item];
+			if (next.program != item.program || next.material != item.material
+				|| next.mesh->getVao() != item.mesh->getVao()) {
+				break;
+			}
+			end++;
+		}
+
+		auto& program = *m_programs[item.program];
+		program.activate();
+		state.bindVertexArray(item.mesh->getVao());
+		// GL 3.3 has no base instance, so each batch points the attributes at its own range.
+		bindInstanceAttributes(first);
+		item.mesh->bindTextures(program);
+		glDrawElementsInstanced(GL_TRIANGLES, item.mesh->getFaceCount(), GL_UNSIGNED_INT, nullptr,
+			static_cast<GLsizei>(end - first));
+		drawCalls++;
+		first = end;
+	}
+
+	m_items.clear();
+	m_instances.clear();
+	m_keys.clear();
+	return drawCalls;
+}
@@ -1,8 +1,10 @@
 #include "ShaderProgram.h"
+#include "GLState.h"
 #include <glad/glad.h>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <string_view>
 
 ShaderProgram::ShaderProgram()
     : m_programId(-1) {
@@ -88,54 +90,180 @@ void ShaderProgram::load(const std::string& vertexShaderPath, const std::string&
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    reflectUniforms();
+}
+
+void ShaderProgram::reflectUniforms()
+{
+    m_uniforms.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_programId, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength, '\0');
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_programId, i, maxLength, &length, &size, &type, name.data());
+        std::string_view uniformName(name.data(), length);
+
+        // Members of uniform blocks have no location; they are set through their buffer.
+        auto location = glGetUniformLocation(m_programId, name.c_str());
+        if (location < 0)
+        {
+            continue;
+        }
+
+        // Arrays of plain types are reported once, as "name[0]". Register every element, and
+        // the bare name for element 0, the way glGetUniformLocation accepts them.
+        auto bracket = uniformName.size() > 3 && uniformName.ends_with("[0]") ? uniformName.size() - 3 : std::string_view::npos;
+        if (bracket == std::string_view::npos)
+        {
+            m_uniforms[UniformName(uniformName).hash] = UniformInfo{ location, type };
+            continue;
+        }
+        auto arrayName = std::string(uniformName.substr(0, bracket));
+        m_uniforms[UniformName(arrayName).hash] = UniformInfo{ location, type };
+        for (GLint element = 0; element < size; element++)
+        {
+            auto elementName = arrayName + "[" + std::to_string(element) + "]";
+            auto elementLocation = glGetUniformLocation(m_programId, elementName.c_str());
+            if (elementLocation >= 0)
+            {
+                m_uniforms[UniformName::element(arrayName, element).hash] = UniformInfo{ elementLocation, type };
+            }
+        }
+    }
 }
 
 void ShaderProgram::activate()
 {
-    glUseProgram(m_programId);
+    GLState::instance().useProgram(m_programId);
+}
+
+bool ShaderProgram::bindUniformBlock(const char* blockName, uint32_t bindingPoint)
+{
+    auto index = glGetUniformBlockIndex(m_programId, blockName);
+    if (index == GL_INVALID_INDEX)
+    {
+        return false;
+    }
+    glUniformBlockBinding(m_programId, index, bindingPoint);
+    return true;
+}
+
+int32_t ShaderProgram::location(UniformName name) const
+{
+    auto it = m_uniforms.find(name.hash);
+    return it == m_uniforms.end() ? -1 : it->second.location;
+}
+
+void ShaderProgram::setSampler(UniformName samplerName, int32_t unit)
+{
+    auto it = m_uniforms.find(samplerName.hash);
+    if (it == m_uniforms.end())
+    {
+        return;
+    }
+    bool changed = it->second.samplerUnit != unit;
+    GLState::instance().countCall(changed);
+    if (changed)
+    {
+        it->second.samplerUnit = unit;
+        upload(it->second.location, unit);
+    }
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, bool value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, int32_t value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, float value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::vec2& value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::vec3& value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::vec4& value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::mat2& value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::mat3& value)
+{
+    upload(location(uniformName), value);
+}
+
+void ShaderProgram::setUniform(UniformName uniformName, const glm::mat4& value)
+{
+    upload(location(uniformName), value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, bool value)
+void ShaderProgram::upload(int32_t location, bool value)
 {
-    glUniform1i(glGetUniformLocation(m_programId, uniformName.c_str()), (int32_t)value);
+    glUniform1i(location, (int32_t)value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, int32_t value)
+void ShaderProgram::upload(int32_t location, int32_t value)
 {
-    glUniform1i(glGetUniformLocation(m_programId, uniformName.c_str()), value);
+    glUniform1i(location, value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, float value)
+void ShaderProgram::upload(int32_t location, float value)
 {
-    glUniform1f(glGetUniformLocation(m_programId, uniformName.c_str()), value);
+    glUniform1f(location, value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::vec2& value)
+void ShaderProgram::upload(int32_t location, const glm::vec2& value)
 {
-    glUniform2fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, &value[0]);
+    glUniform2fv(location, 1, &value[0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::vec3& value)
+void ShaderProgram::upload(int32_t location, const glm::vec3& value)
 {
-    glUniform3fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, &value[0]);
+    glUniform3fv(location, 1, &value[0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::vec4& value)
+void ShaderProgram::upload(int32_t location, const glm::vec4& value)
 {
-    glUniform4fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, &value[0]);
+    glUniform4fv(location, 1, &value[0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::mat2& value)
+void ShaderProgram::upload(int32_t location, const glm::mat2& value)
 {
-    glUniformMatrix2fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, false, &value[0][0]);
+    glUniformMatrix2fv(location, 1, false, &value[0][0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::mat3& value)
+void ShaderProgram::upload(int32_t location, const glm::mat3& value)
 {
-    glUniformMatrix3fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, false, &value[0][0]);
+    glUniformMatrix3fv(location, 1, false, &value[0][0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::mat4& value)
+void ShaderProgram::upload(int32_t location, const glm::mat4& value)
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, false, &value[0][0]);
+    glUniformMatrix4fv(location, 1, false, &value[0][0]);
 }
@@ -4,16 +4,34 @@
 #include <string>
 #include <iostream>
 
-StbImage::StbImage() : m_width(0), m_height(0), m_bpp(0) {
+StbImage::StbImage() : m_width(0), m_height(0), m_bpp(0), m_channels(0) {
 }
 
-void StbImage::loadFromFile(const std::string& filepath) {
-    unsigned char* data = stbi_load(filepath.c_str(), &m_width, &m_height, &m_bpp, 4);
+void StbImage::loadFromFile(const std::string& filepath, int desiredChannels) {
+    unsigned char* data = stbi_load(filepath.c_str(), &m_width, &m_height, &m_bpp, desiredChannels);
 
     if (data == nullptr)
         throw std::runtime_error("Could not load file " + filepath);
 
     m_data = std::unique_ptr<unsigned char[]>(data);
+    m_channels = desiredChannels != 0 ? desiredChannels : m_bpp;
+}
+
+void StbImage::loadFromMemory(const unsigned char* bytes, size_t size, const std::string& name, int desiredChannels) {
+    unsigned char* data = stbi_load_from_memory(bytes, static_cast<int>(size), &m_width, &m_height, &m_bpp, desiredChannels);
+
+    if (data == nullptr)
+        throw std::runtime_error("Could not load file " + name);
+
+    m_data = std::unique_ptr<unsigned char[]>(data);
+    m_channels = desiredChannels != 0 ? desiredChannels : m_bpp;
+}
+
+int StbImage::channelsInFile(const unsigned char* bytes, size_t size) {
+    int width, height, channels;
+    if (!stbi_info_from_memory(bytes, static_cast<int>(size), &width, &height, &channels))
+        return 0;
+    return channels;
 }
 
 int StbImage::getWidth() const { return m_width; }
@@ -22,4 +40,6 @@ int StbImage::getHeight() const { return m_height; }
 
 int StbImage::getBpp() const { return m_bpp; }
 
+int StbImage::getChannels() const { return m_channels; }
+
 unsigned char* StbImage::getData() const { return m_data.get(); }
\ No newline at end of file
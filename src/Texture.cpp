@@ -0,0 +1,26 @@
+#include "Texture.h"
+#include "TextureResidency.h"
+
+Texture::Texture(uint32_t textureId) : m_textureId(textureId) {
+}
+
+Texture::~Texture() {
+	if (m_textureId != 0) {
+		TextureResidency::instance().release(m_textureId);
+	}
+}
+
+Texture::Texture(Texture&& other) noexcept : m_textureId(other.m_textureId) {
+	other.m_textureId = 0;
+}
+
+Texture& Texture::operator=(Texture&& other) noexcept {
+	if (this != &other) {
+		if (m_textureId != 0) {
+			TextureResidency::instance().release(m_textureId);
+		}
+		m_textureId = other.m_textureId;
+		other.m_textureId = 0;
+	}
+	return *this;
+}
@@ -0,0 +1,441 @@
+#include "TextureCooker.h"
+#include "Hash.h"
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+	const char TEXTURE_CACHE_MAGIC[8] = { 'F', 'O', 'G', 'L', 'T', 'E', 'X', '1' };
+	const std::filesystem::path TEXTURE_CACHE_DIRECTORY = "cache/textures";
+
+	struct TextureCacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t format;
+		uint64_t contentHash;
+		uint32_t levelCount;
+		uint32_t srgb;
+	};
+
+	struct LevelRecord {
+		int32_t width;
+		int32_t height;
+		// Offsets are from the start of the file, so a mapped file can be uploaded in place.
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	/**
+	 * @brief Copies the 4x4 block of pixels at the given block coordinates as RGBA, repeating
+	 * the last row and column for blocks that hang over the edge of a small mip level.
+	 * Missing channels read as 0 (green, blue) or 255 (alpha).
+	 */
+	void fetchBlock(const MipImage& image, int32_t blockX, int32_t blockY, uint8_t block[64]) {
+		for (int32_t y = 0; y < 4; y++) {
+			int32_t sourceY = std::min(blockY * 4 + y, image.height - 1);
+			for (int32_t x = 0; x < 4; x++) {
+				int32_t sourceX = std::min(blockX * 4 + x, image.width - 1);
+				const uint8_t* pixel = image.pixels + (static_cast<size_t>(sourceY) * image.width + sourceX) * image.channels;
+				uint8_t* out = block + (y * 4 + x) * 4;
+				out[0] = pixel[0];
+				out[1] = image.channels > 1 ? pixel[1] : 0;
+				out[2] = image.channels > 2 ? pixel[2] : 0;
+				out[3] = image.channels > 3 ? pixel[3] : 255;
+			}
+		}
+	}
+
+	uint16_t packRgb565(const uint8_t* color) {
+		uint16_t r = static_cast<uint16_t>((color[0] * 31 + 127) / 255);
+		uint16_t g = static_cast<uint16_t>((color[1] * 63 + 127) / 255);
+		uint16_t b = static_cast<uint16_t>((color[2] * 31 + 127) / 255);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackRgb565(uint16_t packed, int32_t color[3]) {
+		int32_t r = (packed >> 11) & 31;
+		int32_t g = (packed >> 5) & 63;
+		int32_t b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	 * @brief Encodes the RGB of a block as a BC1 color block (also the color half of BC3).
+	 * The endpoints are the extreme pixels along the principal axis of the block's colors.
+	 */
+	void encodeColorBlock(const uint8_t block[64], uint8_t* out) {
+		float mean[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 3; c++) {
+				mean[c] += block[i * 4 + c];
+			}
+		}
+		for (int c = 0; c < 3; c++) {
+			mean[c] /= 16;
+		}
+
+		// Covariance: xx, xy, xz, yy, yz, zz.
+		float cov[6] = { 0, 0, 0, 0, 0, 0 };
+		float low[3] = { 255, 255, 255 };
+		float high[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++) {
+			float d[3];
+			for (int c = 0; c < 3; c++) {
+				d[c] = block[i * 4 + c] - mean[c];
+				low[c] = std::min(low[c], static_cast<float>(block[i * 4 + c]));
+				high[c] = std::max(high[c], static_cast<float>(block[i * 4 + c]));
+			}
+			cov[0] += d[0] * d[0];
+			cov[1] += d[0] * d[1];
+			cov[2] += d[0] * d[2];
+			cov[3] += d[1] * d[1];
+			cov[4] += d[1] * d[2];
+			cov[5] += d[2] * d[2];
+		}
+
+		// A few power iterations from the bounding box diagonal find the principal axis.
+		float axis[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+		for (int iteration = 0; iteration < 4; iteration++) {
+			float next[3] = {
+				cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+				cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+				cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2],
+			};
+			float largest = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+			if (largest < 1e-6f) {
+				break;
+			}
+			for (int c = 0; c < 3; c++) {
+				axis[c] = next[c] / largest;
+			}
+		}
+
+		int minIndex = 0, maxIndex = 0;
+		float minDot = std::numeric_limits<float>::max();
+		float maxDot = std::numeric_limits<float>::lowest();
+		for (int i = 0; i < 16; i++) {
+			float dot = 0;
+			for (int c = 0; c < 3; c++) {
+				dot += (block[i * 4 + c] - mean[c]) * axis[c];
+			}
+			if (dot < minDot) {
+				minDot = dot;
+				minIndex = i;
+			}
+			if (dot > maxDot) {
+				maxDot = dot;
+				maxIndex = i;
+			}
+		}
+
+		uint16_t color0 = packRgb565(block + maxIndex * 4);
+		uint16_t color1 = packRgb565(block + minIndex * 4);
+		// color0 > color1 selects the four-color palette.
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+		out[0] = static_cast<uint8_t>(color0 & 0xFF);
+		out[1] = static_cast<uint8_t>(color0 >> 8);
+		out[2] = static_cast<uint8_t>(color1 & 0xFF);
+		out[3] = static_cast<uint8_t>(color1 >> 8);
+
+		uint32_t indices = 0;
+		if (color0 != color1) {
+			int32_t palette[4][3];
+			unpackRgb565(color0, palette[0]);
+			unpackRgb565(color1, palette[1]);
+			for (int c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; i++) {
+				uint32_t best = 0;
+				int32_t bestError = std::numeric_limits<int32_t>::max();
+				for (uint32_t p = 0; p < 4; p++) {
+					int32_t error = 0;
+					for (int c = 0; c < 3; c++) {
+						int32_t d = block[i * 4 + c] - palette[p][c];
+						error += d * d;
+					}
+					if (error < bestError) {
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+		}
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	/**
+	 * @brief Encodes one channel of a block as a BC4 block (also the alpha half of BC3 and each
+	 * half of BC5), using the eight-value palette between the channel's min and max.
+	 */
+	void encodeChannelBlock(const uint8_t block[64], int channel, uint8_t* out) {
+		uint8_t low = 255, high = 0;
+		for (int i = 0; i < 16; i++) {
+			low = std::min(low, block[i * 4 + channel]);
+			high = std::max(high, block[i * 4 + channel]);
+		}
+		out[0] = high;
+		out[1] = low;
+
+		uint64_t indices = 0;
+		if (high != low) {
+			int32_t palette[8] = { high, low };
+			for (int i = 1; i <= 6; i++) {
+				palette[i + 1] = ((7 - i) * high + i * low) / 7;
+			}
+			for (int i = 0; i < 16; i++) {
+				uint64_t best = 0;
+				int32_t bestError = std::numeric_limits<int32_t>::max();
+				for (uint64_t p = 0; p < 8; p++) {
+					int32_t error = std::abs(block[i * 4 + channel] - palette[p]);
+					if (error < bestError) {
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= best << (3 * i);
+			}
+		}
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+		}
+	}
+
+	/**
+	 * @brief Zero bytes needed after a level of the given size to keep the next one 4-byte aligned.
+	 */
+	size_t paddingFor(size_t length) {
+		return (4 - length % 4) % 4;
+	}
+
+	/**
+	 * @brief Appends one mip level, encoded in the given format, to the texture's storage.
+	 */
+	void appendLevel(const MipImage& image, TextureFormat format, TextureLevels& texture) {
+		// Keep every level 4-byte aligned, including odd-sized uncompressed ones.
+		size_t offset = (texture.ownedData.size() + 3) & ~size_t(3);
+		TextureLevel level = { image.width, image.height, offset, levelBytes(format, image.width, image.height) };
+		texture.ownedData.resize(level.offset + level.size);
+		uint8_t* out = texture.ownedData.data() + level.offset;
+
+		if (blockBytes(format) == 0) {
+			// The image was decoded with exactly the channels this format stores.
+			std::memcpy(out, image.pixels, level.size);
+		}
+		else {
+			int32_t blocksWide = (image.width + 3) / 4;
+			int32_t blocksHigh = (image.height + 3) / 4;
+			uint8_t block[64];
+			for (int32_t by = 0; by < blocksHigh; by++) {
+				for (int32_t bx = 0; bx < blocksWide; bx++) {
+					fetchBlock(image, bx, by, block);
+					switch (format) {
+					case TextureFormat::BC1:
+						encodeColorBlock(block, out);
+						break;
+					case TextureFormat::BC3:
+						encodeChannelBlock(block, 3, out);
+						encodeColorBlock(block, out + 8);
+						break;
+					case TextureFormat::BC4:
+						encodeChannelBlock(block, 0, out);
+						break;
+					case TextureFormat::BC5:
+						encodeChannelBlock(block, 0, out);
+						encodeChannelBlock(block, 1, out + 8);
+						break;
+					default:
+						break;
+					}
+					out += blockBytes(format);
+				}
+			}
+		}
+		texture.levels.push_back(level);
+	}
+}
+
+int decodeChannelsFor(TextureRole role, int sourceChannels) {
+	switch (role) {
+	case TextureRole::Specular:
+	case TextureRole::Height:
+		return 1;
+	case TextureRole::Normal:
+		return 2;
+	default:
+		// Grey and grey-alpha base colors are expanded, since there is no sRGB R8 or RG8.
+		return (sourceChannels == 2 || sourceChannels == 4) ? 4 : 3;
+	}
+}
+
+TextureFormat chooseTextureFormat(const StbImage& image, TextureRole role, const TextureCookOptions& options) {
+	switch (role) {
+	case TextureRole::Specular:
+	case TextureRole::Height:
+		return options.compress ? TextureFormat::BC4 : TextureFormat::R8;
+	case TextureRole::Normal:
+		return options.compress ? TextureFormat::BC5 : TextureFormat::RG8;
+	default:
+		break;
+	}
+
+	// Many RGBA images never use their alpha channel.
+	bool translucent = false;
+	if (image.getChannels() == 4) {
+		auto pixels = image.getData();
+		size_t count = static_cast<size_t>(image.getWidth()) * image.getHeight();
+		for (size_t i = 0; i < count && !translucent; i++) {
+			translucent = pixels[i * 4 + 3] != 255;
+		}
+	}
+	// Base color must stay sRGB, so without sRGB BC1/BC3 it is better left uncompressed than
+	// compressed as linear color, which would be encoded a second time on output.
+	if (options.compress && options.allowS3TC && options.allowCompressedSRGB) {
+		return translucent ? TextureFormat::BC3 : TextureFormat::BC1;
+	}
+	return translucent ? TextureFormat::RGBA8 : TextureFormat::RGB8;
+}
+
+bool cookAsSRGB(TextureRole role, TextureFormat format, const TextureCookOptions& options) {
+	if (role != TextureRole::BaseColor) {
+		return false;
+	}
+	return blockBytes(format) == 0 || options.allowCompressedSRGB;
+}
+
+TextureLevels cookTexture(const StbImage& image, TextureFormat format, bool srgb) {
+	TextureLevels texture;
+	texture.format = format;
+	texture.srgb = srgb;
+
+	MipImage level = { image.getWidth(), image.getHeight(), image.getChannels(), image.getData(), {} };
+	// An opaque RGBA image cooked to RGB8 drops its alpha before building the chain.
+	if (pixelBytes(format) != 0 && static_cast<int32_t>(pixelBytes(format)) != level.channels) {
+		auto channels = static_cast<int32_t>(pixelBytes(format));
+		size_t count = static_cast<size_t>(level.width) * level.height;
+		level.storage.resize(count * channels);
+		for (size_t i = 0; i < count; i++) {
+			for (int32_t c = 0; c < channels; c++) {
+				level.storage[i * channels + c] = c < level.channels ? level.pixels[i * level.channels + c] : 255;
+			}
+		}
+		level.channels = channels;
+		level.pixels = level.storage.data();
+	}
+
+	appendLevel(level, format, texture);
+	for (auto& mip : generateMipChain(level)) {
+		appendLevel(mip, format, texture);
+	}
+	return texture;
+}
+
+std::filesystem::path textureCachePath(uint64_t contentHash, TextureRole role, const TextureCookOptions& options) {
+	uint64_t key = fnv1a(&contentHash, sizeof(contentHash));
+	key = fnv1a(&role, sizeof(role), key);
+	key = fnv1a(&options.compress, sizeof(options.compress), key);
+	key = fnv1a(&options.allowS3TC, sizeof(options.allowS3TC), key);
+	key = fnv1a(&options.allowCompressedSRGB, sizeof(options.allowCompressedSRGB), key);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.tex", static_cast<unsigned long long>(key));
+	return TEXTURE_CACHE_DIRECTORY / name;
+}
+
+bool loadCookedTexture(const std::filesystem::path& cachePath, uint64_t contentHash, TextureLevels& texture) {
+	auto mapping = std::make_shared<MappedFile>();
+	if (!mapping->open(cachePath) || mapping->size() < sizeof(TextureCacheHeader)) {
+		return false;
+	}
+
+	auto header = reinterpret_cast<const TextureCacheHeader*>(mapping->data());
+	if (std::memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) != 0
+		|| header->version != TEXTURE_CACHE_VERSION
+		|| header->contentHash != contentHash
+		|| header->format > static_cast<uint32_t>(TextureFormat::RGB8)
+		|| header->levelCount == 0
+		|| header->levelCount > 32
+		|| mapping->size() < sizeof(TextureCacheHeader) + header->levelCount * sizeof(LevelRecord)) {
+		return false;
+	}
+
+	TextureLevels result;
+	result.format = static_cast<TextureFormat>(header->format);
+	result.srgb = header->srgb != 0;
+	auto records = reinterpret_cast<const LevelRecord*>(mapping->data() + sizeof(TextureCacheHeader));
+	for (uint32_t i = 0; i < header->levelCount; i++) {
+		auto& record = records[i];
+		if (record.width <= 0 || record.height <= 0
+			|| record.size != levelBytes(result.format, record.width, record.height)
+			|| record.offset > mapping->size() || record.size > mapping->size() - record.offset) {
+			return false;
+		}
+		result.levels.push_back(TextureLevel{ record.width, record.height,
+			static_cast<size_t>(record.offset), static_cast<size_t>(record.size) });
+	}
+
+	result.mapping = std::move(mapping);
+	texture = std::move(result);
+	return true;
+}
+
+void storeCookedTexture(const std::filesystem::path& cachePath, uint64_t contentHash, const TextureLevels& texture) {
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(cachePath.parent_path(), error);
+
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::cerr << "Could not write texture cache " << tempPath << std::endl;
+			return;
+		}
+
+		TextureCacheHeader header = {};
+		std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+		header.version = TEXTURE_CACHE_VERSION;
+		header.format = static_cast<uint32_t>(texture.format);
+		header.contentHash = contentHash;
+		header.levelCount = static_cast<uint32_t>(texture.levels.size());
+		header.srgb = texture.srgb ? 1 : 0;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// Level data starts right after the records, with each level padded to 4 bytes.
+		uint64_t offset = sizeof(TextureCacheHeader) + texture.levels.size() * sizeof(LevelRecord);
+		for (auto& level : texture.levels) {
+			LevelRecord record = { level.width, level.height, offset, level.size };
+			out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+			offset += level.size + paddingFor(level.size);
+		}
+		const char zeros[4] = {};
+		for (size_t i = 0; i < texture.levels.size(); i++) {
+			out.write(reinterpret_cast<const char*>(texture.levelData(i)), texture.levels[i].size);
+			out.write(zeros, paddingFor(texture.levels[i].size));
+		}
+
+		if (!out) {
+			std::cerr << "Could not write texture cache " << tempPath << std::endl;
+			out.close();
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error) {
+		std::cerr << "Could not write texture cache " << cachePath << ": " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+	}
+}
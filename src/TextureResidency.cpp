@@ -0,0 +1,123 @@
+#include "TextureResidency.h"
+#include "GLState.h"
+#include <algorithm>
+
+namespace {
+	const size_t DEFAULT_TEXTURE_BUDGET = size_t(512) << 20;
+	const int32_t DEFAULT_MINIMUM_SIZE = 64;
+	const size_t DEFAULT_RESTORE_BYTES_PER_FRAME = size_t(16) << 20;
+}
+
+TextureResidency::TextureResidency() : m_budget(DEFAULT_TEXTURE_BUDGET), m_residentBytes(0),
+	m_minimumSize(DEFAULT_MINIMUM_SIZE), m_restoreBytesPerFrame(DEFAULT_RESTORE_BYTES_PER_FRAME), m_frame(1) {
+	// Textures release themselves through GLState, so it must be constructed first and outlive us.
+	GLState::instance();
+}
+
+TextureResidency& TextureResidency::instance() {
+	static TextureResidency residency;
+	return residency;
+}
+
+size_t TextureResidency::bytesFrom(const TextureLevels& levels, size_t firstLevel) {
+	size_t bytes = 0;
+	for (size_t i = firstLevel; i < levels.levels.size(); i++) {
+		bytes += levels.levels[i].size;
+	}
+	return bytes;
+}
+
+void TextureResidency::setBudget(size_t bytes) {
+	m_budget = bytes;
+}
+
+Texture TextureResidency::upload(TextureLevels&& levels) {
+	Record record;
+	if (levels.mapping) {
+		while (record.lowestFirstLevel + 1 < levels.levels.size()) {
+			auto& next = levels.levels[record.lowestFirstLevel + 1];
+			if (std::max(next.width, next.height) < m_minimumSize) {
+				break;
+			}
+			record.lowestFirstLevel++;
+		}
+	}
+
+	// Start small enough to fit, if possible; endFrame() restores the rest once it is drawn.
+	while (record.firstLevel < record.lowestFirstLevel
+		&& m_residentBytes + bytesFrom(levels, record.firstLevel) > m_budget) {
+		record.firstLevel++;
+	}
+
+	auto texture = Texture::loadLevels(levels, record.firstLevel);
+	auto textureId = texture.getId();
+	record.residentBytes = bytesFrom(levels, record.firstLevel);
+	record.lastDrawnFrame = m_frame;
+	m_residentBytes += record.residentBytes;
+	if (levels.mapping) {
+		record.levels = std::move(levels);
+	}
+	m_textures.emplace(textureId, std::move(record));
+	return texture;
+}
+
+void TextureResidency::release(uint32_t textureId) {
+	auto it = m_textures.find(textureId);
+	if (it != m_textures.end()) {
+		m_residentBytes -= it->second.residentBytes;
+		m_textures.erase(it);
+	}
+	GLState::instance().deleteTexture(textureId);
+}
+
+void TextureResidency::setFirstLevel(uint32_t textureId, Record& record, size_t firstLevel) {
+	GLState::instance().bindTexture(0, textureId);
+	Texture::uploadLevels(record.levels, firstLevel);
+
+	m_residentBytes -= record.residentBytes;
+	record.firstLevel = firstLevel;
+	record.residentBytes = bytesFrom(record.levels, firstLevel);
+	m_residentBytes += record.residentBytes;
+}
+
+void TextureResidency::endFrame() {
+	// Over budget: shrink the texture that has gone undrawn the longest, one level at a time.
+	// Textures drawn this frame are only shrunk once nothing else can be.
+	while (m_residentBytes > m_budget) {
+		uint32_t victimId = 0;
+		Record* victim = nullptr;
+		for (auto& [id, record] : m_textures) {
+			if (record.firstLevel < record.lowestFirstLevel
+				&& (victim == nullptr || record.lastDrawnFrame < victim->lastDrawnFrame)) {
+				victimId = id;
+				victim = &record;
+			}
+		}
+		if (victim == nullptr) {
+			break;
+		}
+		setFirstLevel(victimId, *victim, victim->firstLevel + 1);
+	}
+
+	// Under budget: bring back one level of each downscaled texture that was drawn this frame.
+	size_t restored = 0;
+	for (auto& [id, record] : m_textures) {
+		if (record.lastDrawnFrame != m_frame || record.firstLevel == 0) {
+			continue;
+		}
+		size_t growth = record.levels.levels[record.firstLevel - 1].size;
+		// A single level larger than the per-frame cap is still restored, on a frame of its own.
+		if (m_residentBytes + growth > m_budget || (restored > 0 && restored + growth > m_restoreBytesPerFrame)) {
+			continue;
+		}
+		setFirstLevel(id, record, record.firstLevel - 1);
+		restored += growth;
+	}
+
+	m_frame++;
+}
+
+size_t TextureResidency::bytesOf(uint32_t textureId) const {
+	auto it = m_textures.find(textureId);
+	return it == m_textures.end() ? 0 : it->second.residentBytes;
+}
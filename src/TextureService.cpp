@@ -0,0 +1,255 @@
+#include "TextureService.h"
+#include "Hash.h"
+#include "TextureResidency.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+TextureService::TextureService(ThreadPool& pool) : m_pool(pool) {
+	// Unclaimed textures are released through TextureResidency, so it must outlive us.
+	TextureResidency::instance();
+}
+
+TextureService& TextureService::instance() {
+	static TextureService service(ThreadPool::shared());
+	return service;
+}
+
+void TextureService::detectCapabilities() {
+	bool s3tc = false;
+	bool srgb = false;
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (name == nullptr) {
+			continue;
+		}
+		if (std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+			s3tc = true;
+		}
+		else if (std::strcmp(name, "GL_EXT_texture_sRGB") == 0) {
+			srgb = true;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cookOptions.allowS3TC = s3tc;
+	m_cookOptions.allowCompressedSRGB = s3tc && srgb;
+}
+
+void TextureService::setCompressionEnabled(bool enabled) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cookOptions.compress = enabled;
+}
+
+std::shared_ptr<TextureService::Entry> TextureService::requestEntry(const std::filesystem::path& path,
+	TextureRole role, std::function<void()> onDecoded) {
+	// "models/a/../a/x.png" and "models/a/x.png" are the same file. The same file used in two
+	// roles is cooked twice, since each role has its own format.
+	std::error_code error;
+	auto normalized = std::filesystem::weakly_canonical(path, error);
+	auto key = (error ? path.lexically_normal() : normalized).generic_string();
+	key += "#" + std::to_string(static_cast<uint32_t>(role));
+
+	std::shared_ptr<Entry> entry;
+	bool isNew = false;
+	bool callNow = static_cast<bool>(onDecoded);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto& slot = m_byPath[key];
+		if (!slot) {
+			slot = std::make_shared<Entry>();
+			slot->path = path;
+			slot->role = role;
+			isNew = true;
+		}
+		entry = slot;
+		if (callNow && entry->state == EntryState::Decoding) {
+			entry->onDecoded.push_back(std::move(onDecoded));
+			callNow = false;
+		}
+	}
+	if (isNew) {
+		m_pool.enqueue([this, entry]() { decode(entry); });
+	}
+	if (callNow) {
+		// The image was already decoded when we looked.
+		onDecoded();
+	}
+	return entry;
+}
+
+void TextureService::request(const std::filesystem::path& path, TextureRole role, std::function<void()> onDecoded) {
+	requestEntry(path, role, std::move(onDecoded));
+}
+
+void TextureService::decode(std::shared_ptr<Entry> entry) {
+	std::ifstream file(entry->path, std::ios::binary);
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!file.is_open() || bytes.empty()) {
+		entry->error = "Could not load file " + entry->path.string();
+		finishDecode(*entry, EntryState::Failed);
+		return;
+	}
+
+	// If a different path already holds these exact bytes, share its texture instead.
+	uint64_t contentHash = fnv1a(bytes.data(), bytes.size());
+	contentHash = fnv1a(&entry->role, sizeof(entry->role), contentHash);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		entry->contentHash = contentHash;
+		auto existing = m_byContent.find(contentHash);
+		if (existing != m_byContent.end()) {
+			entry->alias = existing->second;
+		}
+		else {
+			m_byContent.emplace(contentHash, entry);
+		}
+	}
+	if (entry->alias) {
+		finishDecode(*entry, EntryState::Decoded);
+		return;
+	}
+
+	// A warm start finds the cooked mip chain on disk and never decodes the image at all.
+	TextureCookOptions options;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		options = m_cookOptions;
+	}
+	auto cachePath = textureCachePath(contentHash, entry->role, options);
+	if (loadCookedTexture(cachePath, contentHash, entry->levels)) {
+		finishDecode(*entry, EntryState::Decoded);
+		return;
+	}
+
+	try {
+		// Decode only the channels the role uses, so a specular map is never expanded to RGBA.
+		int channels = decodeChannelsFor(entry->role, StbImage::channelsInFile(bytes.data(), bytes.size()));
+		StbImage image;
+		image.loadFromMemory(bytes.data(), bytes.size(), entry->path.string(), channels);
+		auto format = chooseTextureFormat(image, entry->role, options);
+		entry->levels = cookTexture(image, format, cookAsSRGB(entry->role, format, options));
+	}
+	catch (std::runtime_error& e) {
+		entry->error = e.what();
+		finishDecode(*entry, EntryState::Failed);
+		return;
+	}
+	storeCookedTexture(cachePath, contentHash, entry->levels);
+	// Swap the freshly cooked pixels for a mapping of the cache file, which costs no memory to
+	// keep around for TextureResidency.
+	TextureLevels mapped;
+	if (loadCookedTexture(cachePath, contentHash, mapped)) {
+		entry->levels = std::move(mapped);
+	}
+	finishDecode(*entry, EntryState::Decoded);
+}
+
+void TextureService::finishDecode(Entry& entry, EntryState state) {
+	std::vector<std::function<void()>> callbacks;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		entry.state = state;
+		callbacks.swap(entry.onDecoded);
+		if (state == EntryState::Decoded && !entry.alias) {
+			m_uploadQueue.push_back(m_byContent.at(entry.contentHash));
+		}
+	}
+	m_decodedChanged.notify_all();
+	for (auto& callback : callbacks) {
+		callback();
+	}
+}
+
+std::shared_ptr<const Texture> TextureService::upload(Entry& entry) {
+	// The residency manager keeps the (mapped) mip chain to drop and restore levels later.
+	auto texture = std::make_shared<const Texture>(TextureResidency::instance().upload(std::move(entry.levels)));
+	entry.levels = TextureLevels();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	entry.texture = texture;
+	entry.state = EntryState::Uploaded;
+	return texture;
+}
+
+void TextureService::forget(const std::shared_ptr<Entry>& entry) {
+	// Paths whose images turned out to be identical share the entry through their alias.
+	for (auto it = m_byPath.begin(); it != m_byPath.end();) {
+		if (it->second == entry || it->second->alias == entry) {
+			it = m_byPath.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	auto content = m_byContent.find(entry->contentHash);
+	if (content != m_byContent.end() && content->second == entry) {
+		m_byContent.erase(content);
+	}
+}
+
+TextureBinding TextureService::load(const std::filesystem::path& path, const std::string& samplerName) {
+	for (;;) {
+		auto entry = requestEntry(path, textureRoleFor(samplerName), nullptr);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_decodedChanged.wait(lock, [&entry]() { return entry->state != EntryState::Decoding; });
+		// An alias is marked decoded as soon as it is recognized, before its target may be.
+		while (entry->alias) {
+			entry = entry->alias;
+			m_decodedChanged.wait(lock, [&entry]() { return entry->state != EntryState::Decoding; });
+		}
+
+		if (entry->state == EntryState::Failed) {
+			throw std::runtime_error(entry->error);
+		}
+		if (entry->state == EntryState::Decoded) {
+			// Only the GL thread moves an entry from Decoded to Uploaded, so it is safe to unlock.
+			lock.unlock();
+			return TextureBinding{ upload(*entry), samplerName };
+		}
+		auto texture = std::move(entry->unclaimed);
+		if (!texture) {
+			texture = entry->texture.lock();
+		}
+		if (texture) {
+			return TextureBinding{ texture, samplerName };
+		}
+		// Every mesh that used the texture is gone, so it was deleted. Request the image again;
+		// its cooked mip chain is still cached on disk.
+		forget(entry);
+	}
+}
+
+size_t TextureService::uploadReady() {
+	std::deque<std::shared_ptr<Entry>> ready;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ready.swap(m_uploadQueue);
+	}
+	size_t uploaded = 0;
+	for (auto& entry : ready) {
+		// load() may have uploaded it on demand already.
+		if (entry->state == EntryState::Decoded) {
+			entry->unclaimed = upload(*entry);
+			uploaded++;
+		}
+	}
+	return uploaded;
+}
+
+void TextureService::clear() {
+	std::vector<std::shared_ptr<const Texture>> unclaimed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& [hash, entry] : m_byContent) {
+			if (entry->unclaimed) {
+				unclaimed.push_back(std::move(entry->unclaimed));
+			}
+		}
+	}
+	// Deleted here, on the GL thread, rather than under the lock.
+	unclaimed.clear();
+}
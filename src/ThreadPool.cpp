@@ -0,0 +1,55 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount) : m_stopping(false) {
+	threadCount = std::max<size_t>(threadCount, 1);
+	m_workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_available.notify_all();
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_available.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_available.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+			// Finish whatever is already queued before shutting down.
+			if (m_tasks.empty()) {
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+size_t ThreadPool::size() const {
+	return m_workers.size();
+}
+
+ThreadPool& ThreadPool::shared() {
+	static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	return pool;
+}
@@ -0,0 +1,252 @@
+#include "TransformKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC emits AVX intrinsics without any per-function opt-in.
+#define TRANSFORM_TARGET_AVX
+#else
+#define TRANSFORM_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace {
+	/**
+	 * @brief Composes lanes [begin, count). Also the reference the SIMD kernels must match bit for
+	 * bit, so all of them evaluate every expression in the same order.
+	 */
+	void composeScalar(const TransformColumns& t, const glm::mat4* baseTransforms, const uint32_t* indices,
+		glm::mat4* results, size_t begin) {
+		for (size_t i = begin; i < t.count; i++) {
+			float w = t.orientationW[i], x = t.orientationX[i], y = t.orientationY[i], z = t.orientationZ[i];
+			float xx = x * x, yy = y * y, zz = z * z;
+			float xy = x * y, xz = x * z, yz = y * z;
+			float wx = w * x, wy = w * y, wz = w * z;
+			float sx = t.scaleX[i], sy = t.scaleY[i], sz = t.scaleZ[i];
+			float cx = t.centerX[i], cy = t.centerY[i], cz = t.centerZ[i];
+
+			// The rotation's columns, each times its scale.
+			glm::vec3 c0((1 - 2 * (yy + zz)) * sx, 2 * (xy + wz) * sx, 2 * (xz - wy) * sx);
+			glm::vec3 c1(2 * (xy - wz) * sy, (1 - 2 * (xx + zz)) * sy, 2 * (yz + wx) * sy);
+			glm::vec3 c2(2 * (xz + wy) * sz, 2 * (yz - wx) * sz, (1 - 2 * (xx + yy)) * sz);
+			// The rotation and scale happen about the center, which then lands at position + center * scale.
+			glm::vec3 translation(
+				(t.positionX[i] + cx * sx) - ((c0.x * cx + c1.x * cy) + c2.x * cz),
+				(t.positionY[i] + cy * sy) - ((c0.y * cx + c1.y * cy) + c2.y * cz),
+				(t.positionZ[i] + cz * sz) - ((c0.z * cx + c1.z * cy) + c2.z * cz));
+
+			auto& base = baseTransforms[indices[i]];
+			auto& result = results[indices[i]];
+			for (int column = 0; column < 4; column++) {
+				auto& b = base[column];
+				result[column] = glm::vec4(c0, 0) * b.x + glm::vec4(c1, 0) * b.y + glm::vec4(c2, 0) * b.z
+					+ glm::vec4(translation, 1) * b.w;
+			}
+		}
+	}
+
+#ifdef TRANSFORM_X86
+	/**
+	 * @brief Writes the affine matrix with the given columns (the last row being 0, 0, 0, 1)
+	 * times the base transform, a column at a time.
+	 */
+	inline void multiplyBaseSSE(__m128 c0, __m128 c1, __m128 c2, __m128 c3, const glm::mat4& base, glm::mat4& result) {
+		for (int column = 0; column < 4; column++) {
+			__m128 b = _mm_loadu_ps(&base[column][0]);
+			__m128 sum = _mm_mul_ps(c0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(&result[column][0], sum);
+		}
+	}
+
+	/**
+	 * @brief Composes lanes from begin four at a time, and returns where it stopped.
+	 */
+	size_t composeSSE(const TransformColumns& t, const glm::mat4* baseTransforms, const uint32_t* indices,
+		glm::mat4* results, size_t begin) {
+		const __m128 one = _mm_set1_ps(1);
+		const __m128 two = _mm_set1_ps(2);
+		size_t i = begin;
+		for (; i + 4 <= t.count; i += 4) {
+			__m128 w = _mm_loadu_ps(t.orientationW + i);
+			__m128 x = _mm_loadu_ps(t.orientationX + i);
+			__m128 y = _mm_loadu_ps(t.orientationY + i);
+			__m128 z = _mm_loadu_ps(t.orientationZ + i);
+			__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+			__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+			__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+			__m128 sx = _mm_loadu_ps(t.scaleX + i);
+			__m128 sy = _mm_loadu_ps(t.scaleY + i);
+			__m128 sz = _mm_loadu_ps(t.scaleZ + i);
+			__m128 cx = _mm_loadu_ps(t.centerX + i);
+			__m128 cy = _mm_loadu_ps(t.centerY + i);
+			__m128 cz = _mm_loadu_ps(t.centerZ + i);
+
+			__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+			__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+			__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+			__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+			__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+			__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+			__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+			__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+			__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+			__m128 tx = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(t.positionX + i), _mm_mul_ps(cx, sx)),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0x, cx), _mm_mul_ps(c1x, cy)), _mm_mul_ps(c2x, cz)));
+			__m128 ty = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(t.positionY + i), _mm_mul_ps(cy, sy)),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0y, cx), _mm_mul_ps(c1y, cy)), _mm_mul_ps(c2y, cz)));
+			__m128 tz = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(t.positionZ + i), _mm_mul_ps(cz, sz)),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0z, cx), _mm_mul_ps(c1z, cy)), _mm_mul_ps(c2z, cz)));
+
+			// Turn the component registers into one column register per lane.
+			__m128 column0[4] = { c0x, c0y, c0z, _mm_setzero_ps() };
+			__m128 column1[4] = { c1x, c1y, c1z, _mm_setzero_ps() };
+			__m128 column2[4] = { c2x, c2y, c2z, _mm_setzero_ps() };
+			__m128 column3[4] = { tx, ty, tz, one };
+			_MM_TRANSPOSE4_PS(column0[0], column0[1], column0[2], column0[3]);
+			_MM_TRANSPOSE4_PS(column1[0], column1[1], column1[2], column1[3]);
+			_MM_TRANSPOSE4_PS(column2[0], column2[1], column2[2], column2[3]);
+			_MM_TRANSPOSE4_PS(column3[0], column3[1], column3[2], column3[3]);
+			for (size_t lane = 0; lane < 4; lane++) {
+				auto index = indices[i + lane];
+				multiplyBaseSSE(column0[lane], column1[lane], column2[lane], column3[lane], baseTransforms[index], results[index]);
+			}
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Transposes the 4x4 block in each 128-bit half of the four registers, as
+	 * _MM_TRANSPOSE4_PS does for a single block.
+	 */
+	TRANSFORM_TARGET_AVX inline void transposeHalves(__m256& a, __m256& b, __m256& c, __m256& d) {
+		__m256 t0 = _mm256_unpacklo_ps(a, b);
+		__m256 t1 = _mm256_unpacklo_ps(c, d);
+		__m256 t2 = _mm256_unpackhi_ps(a, b);
+		__m256 t3 = _mm256_unpackhi_ps(c, d);
+		a = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+		b = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+		c = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		d = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	/**
+	 * @brief multiplyBaseSSE for two lanes at once, one in each half of the column registers.
+	 */
+	TRANSFORM_TARGET_AVX inline void multiplyBasesAVX(__m256 c0, __m256 c1, __m256 c2, __m256 c3,
+		const glm::mat4& lowBase, const glm::mat4& highBase, glm::mat4& lowResult, glm::mat4& highResult) {
+		for (int column = 0; column < 4; column++) {
+			__m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&lowBase[column][0])),
+				_mm_loadu_ps(&highBase[column][0]), 1);
+			__m256 sum = _mm256_mul_ps(c0, _mm256_permute_ps(b, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(c1, _mm256_permute_ps(b, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(c2, _mm256_permute_ps(b, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(c3, _mm256_permute_ps(b, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(&lowResult[column][0], _mm256_castps256_ps128(sum));
+			_mm_storeu_ps(&highResult[column][0], _mm256_extractf128_ps(sum, 1));
+		}
+	}
+
+	/**
+	 * @brief Composes lanes eight at a time, and returns where it stopped.
+	 */
+	TRANSFORM_TARGET_AVX size_t composeAVX(const TransformColumns& t, const glm::mat4* baseTransforms,
+		const uint32_t* indices, glm::mat4* results) {
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256 two = _mm256_set1_ps(2);
+		size_t i = 0;
+		for (; i + 8 <= t.count; i += 8) {
+			__m256 w = _mm256_loadu_ps(t.orientationW + i);
+			__m256 x = _mm256_loadu_ps(t.orientationX + i);
+			__m256 y = _mm256_loadu_ps(t.orientationY + i);
+			__m256 z = _mm256_loadu_ps(t.orientationZ + i);
+			__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+			__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+			__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+			__m256 sx = _mm256_loadu_ps(t.scaleX + i);
+			__m256 sy = _mm256_loadu_ps(t.scaleY + i);
+			__m256 sz = _mm256_loadu_ps(t.scaleZ + i);
+			__m256 cx = _mm256_loadu_ps(t.centerX + i);
+			__m256 cy = _mm256_loadu_ps(t.centerY + i);
+			__m256 cz = _mm256_loadu_ps(t.centerZ + i);
+
+			__m256 c0x = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+			__m256 c0y = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+			__m256 c0z = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+			__m256 c1x = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+			__m256 c1y = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+			__m256 c1z = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+			__m256 c2x = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+			__m256 c2y = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+			__m256 c2z = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+			__m256 tx = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(t.positionX + i), _mm256_mul_ps(cx, sx)),
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0x, cx), _mm256_mul_ps(c1x, cy)), _mm256_mul_ps(c2x, cz)));
+			__m256 ty = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(t.positionY + i), _mm256_mul_ps(cy, sy)),
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0y, cx), _mm256_mul_ps(c1y, cy)), _mm256_mul_ps(c2y, cz)));
+			__m256 tz = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(t.positionZ + i), _mm256_mul_ps(cz, sz)),
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0z, cx), _mm256_mul_ps(c1z, cy)), _mm256_mul_ps(c2z, cz)));
+
+			// Register k now holds lane k's column in its low half and lane k + 4's in its high half.
+			__m256 column0[4] = { c0x, c0y, c0z, zero };
+			__m256 column1[4] = { c1x, c1y, c1z, zero };
+			__m256 column2[4] = { c2x, c2y, c2z, zero };
+			__m256 column3[4] = { tx, ty, tz, one };
+			transposeHalves(column0[0], column0[1], column0[2], column0[3]);
+			transposeHalves(column1[0], column1[1], column1[2], column1[3]);
+			transposeHalves(column2[0], column2[1], column2[2], column2[3]);
+			transposeHalves(column3[0], column3[1], column3[2], column3[3]);
+			for (size_t lane = 0; lane < 4; lane++) {
+				auto low = indices[i + lane];
+				auto high = indices[i + lane + 4];
+				multiplyBasesAVX(column0[lane], column1[lane], column2[lane], column3[lane],
+					baseTransforms[low], baseTransforms[high], results[low], results[high]);
+			}
+		}
+		return i;
+	}
+
+	bool cpuHasAVX() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		// The OS must save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2).
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		return osSavesYmm && (info[2] & (1 << 28)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+#endif
+}
+
+TransformKernel bestTransformKernel() {
+#ifdef TRANSFORM_X86
+	static const TransformKernel best = cpuHasAVX() ? TransformKernel::AVX : TransformKernel::SSE;
+	return best;
+#else
+	return TransformKernel::Scalar;
+#endif
+}
+
+void composeTransforms(const TransformColumns& transforms, const glm::mat4* baseTransforms, const uint32_t* indices,
+	glm::mat4* results, TransformKernel kernel) {
+	if (kernel > bestTransformKernel()) {
+		kernel = bestTransformKernel();
+	}
+	size_t done = 0;
+#ifdef TRANSFORM_X86
+	if (kernel == TransformKernel::AVX) {
+		done = composeAVX(transforms, baseTransforms, indices, results);
+	}
+	if (kernel != TransformKernel::Scalar) {
+		done = composeSSE(transforms, baseTransforms, indices, results, done);
+	}
+#endif
+	composeScalar(transforms, baseTransforms, indices, results, done);
+}
@@ -0,0 +1,246 @@
+#include "TransformStore.h"
+#include <algorithm>
+#include <stdexcept>
+
+Entity TransformStore::allocateEntity(uint32_t slot) {
+	if (m_freeIndices.empty()) {
+		m_slots.push_back(slot);
+		m_generations.push_back(0);
+		return Entity{ static_cast<uint32_t>(m_slots.size() - 1), 0 };
+	}
+	auto index = m_freeIndices.back();
+	m_freeIndices.pop_back();
+	m_slots[index] = slot;
+	return Entity{ index, m_generations[index] };
+}
+
+Entity TransformStore::create(const glm::mat4& baseTransform) {
+	auto slot = static_cast<uint32_t>(m_entities.size());
+	auto entity = allocateEntity(slot);
+	m_parents.push_back(NO_PARENT);
+	m_subtreeSizes.push_back(1);
+	m_positions.emplace_back(0);
+	m_orientations.emplace_back(1, 0, 0, 0);
+	m_scales.emplace_back(1);
+	m_centers.emplace_back(0);
+	m_baseTransforms.push_back(baseTransform);
+	m_locals.push_back(baseTransform);
+	m_worlds.push_back(baseTransform);
+	m_dirty.push_back(0);
+	m_entities.push_back(entity);
+	m_previousPositions.emplace_back(0);
+	m_previousOrientations.emplace_back(1, 0, 0, 0);
+	m_previousScales.emplace_back(1);
+	m_moved.push_back(0);
+	markDirty(slot);
+	return entity;
+}
+
+Entity TransformStore::clone(Entity root) {
+	auto first = m_slots[root.index];
+	auto count = m_subtreeSizes[first];
+	auto copy = static_cast<uint32_t>(m_entities.size());
+	// Append with push_back rather than a self-referencing insert, which is undefined.
+	forEachColumn([&](auto& column) {
+		column.reserve(column.size() + count);
+		for (uint32_t i = 0; i < count; i++) {
+			column.push_back(column[first + i]);
+		}
+	});
+	m_parents[copy] = NO_PARENT;
+	for (uint32_t i = 1; i < count; i++) {
+		m_parents[copy + i] += copy - first;
+	}
+	// Nodes copied with their flags set still need their local matrices composed. The copies
+	// appear where the originals are now, with no motion to interpolate.
+	for (uint32_t i = 0; i < count; i++) {
+		auto slot = copy + i;
+		if (m_dirty[slot]) {
+			m_rebuild.push_back(slot);
+		}
+		m_previousPositions[slot] = m_positions[slot];
+		m_previousOrientations[slot] = m_orientations[slot];
+		m_previousScales[slot] = m_scales[slot];
+		m_moved[slot] = 0;
+	}
+	// The copy's world matrix no longer depends on the original's parent.
+	markDirty(copy);
+	for (uint32_t i = 0; i < count; i++) {
+		m_entities[copy + i] = allocateEntity(copy + i);
+	}
+	return m_entities[copy];
+}
+
+void TransformStore::rotateSlots(uint32_t first, uint32_t middle, uint32_t last) {
+	forEachColumn([&](auto& column) {
+		std::rotate(column.begin() + first, column.begin() + middle, column.begin() + last);
+	});
+	auto renumber = [&](uint32_t slot) {
+		if (slot == NO_PARENT || slot < first || slot >= last) {
+			return slot;
+		}
+		return slot < middle ? slot + (last - middle) : slot - (middle - first);
+	};
+	for (auto& parent : m_parents) {
+		parent = renumber(parent);
+	}
+	for (auto slot = first; slot < last; slot++) {
+		m_slots[m_entities[slot].index] = slot;
+	}
+	m_rescan = true;
+}
+
+void TransformStore::attach(Entity parent, Entity child) {
+	auto childSlot = m_slots[child.index];
+	auto count = m_subtreeSizes[childSlot];
+	if (m_parents[childSlot] != NO_PARENT) {
+		throw std::logic_error("Cannot attach a node that already has a parent");
+	}
+	auto parentSlot = m_slots[parent.index];
+	if (parentSlot >= childSlot && parentSlot < childSlot + count) {
+		throw std::logic_error("Cannot attach a node to its own descendant");
+	}
+
+	// The child is a root, so its subtree lies entirely before or after the parent's.
+	auto end = parentSlot + m_subtreeSizes[parentSlot];
+	if (childSlot > end) {
+		rotateSlots(end, childSlot, childSlot + count);
+	}
+	else if (childSlot + count < end) {
+		rotateSlots(childSlot, childSlot + count, end);
+	}
+
+	parentSlot = m_slots[parent.index];
+	childSlot = m_slots[child.index];
+	m_parents[childSlot] = parentSlot;
+	markDirty(childSlot);
+	for (auto ancestor = parentSlot; ancestor != NO_PARENT; ancestor = m_parents[ancestor]) {
+		m_subtreeSizes[ancestor] += count;
+	}
+}
+
+void TransformStore::destroy(Entity node) {
+	auto first = m_slots[node.index];
+	auto count = m_subtreeSizes[first];
+	for (auto ancestor = m_parents[first]; ancestor != NO_PARENT; ancestor = m_parents[ancestor]) {
+		m_subtreeSizes[ancestor] -= count;
+	}
+	for (auto slot = first; slot < first + count; slot++) {
+		auto index = m_entities[slot].index;
+		m_slots[index] = UINT32_MAX;
+		m_generations[index]++;
+		m_freeIndices.push_back(index);
+	}
+
+	forEachColumn([&](auto& column) {
+		column.erase(column.begin() + first, column.begin() + first + count);
+	});
+	// Nothing outside the subtree had a parent inside it, so only later slots need renumbering.
+	for (auto& parent : m_parents) {
+		if (parent != NO_PARENT && parent > first) {
+			parent -= count;
+		}
+	}
+	for (auto slot = first; slot < m_entities.size(); slot++) {
+		m_slots[m_entities[slot].index] = slot;
+	}
+	m_rescan = true;
+}
+
+void TransformStore::gatherFlags() {
+	// Attaching or destroying moved slots under the lists; a structural change is rare enough
+	// that gathering the flags again is simpler than renumbering them.
+	m_rebuild.clear();
+	m_movedSlots.clear();
+	for (uint32_t slot = 0; slot < m_entities.size(); slot++) {
+		if (m_dirty[slot]) {
+			m_rebuild.push_back(slot);
+		}
+		if (m_moved[slot]) {
+			m_movedSlots.push_back(slot);
+		}
+	}
+	m_rescan = false;
+}
+
+void TransformStore::beginStep() {
+	if (m_rescan) {
+		gatherFlags();
+	}
+	for (auto slot : m_movedSlots) {
+		m_previousPositions[slot] = m_positions[slot];
+		m_previousOrientations[slot] = m_orientations[slot];
+		m_previousScales[slot] = m_scales[slot];
+		m_moved[slot] = 0;
+		// It was last drawn part of the way there.
+		markDirty(slot);
+	}
+	m_movedSlots.clear();
+	m_stepping = true;
+}
+
+glm::mat4 TransformStore::composeLocalAt(size_t slot) const {
+	auto& position = m_positions[slot];
+	auto& orientation = m_orientations[slot];
+	auto& scale = m_scales[slot];
+	auto& center = m_centers[slot];
+	// A batch of one, read straight from the slot's components.
+	TransformColumns columns{
+		&position.x, &position.y, &position.z,
+		&orientation.w, &orientation.x, &orientation.y, &orientation.z,
+		&scale.x, &scale.y, &scale.z,
+		&center.x, &center.y, &center.z,
+		1
+	};
+	uint32_t first = 0;
+	glm::mat4 local;
+	composeTransforms(columns, &m_baseTransforms[slot], &first, &local);
+	return local;
+}
+
+size_t TransformStore::updateWorld(float alpha) {
+	if (m_rescan) {
+		gatherFlags();
+	}
+	// A node the last step moved is drawn somewhere new every frame until the next step.
+	for (auto slot : m_movedSlots) {
+		markDirty(slot);
+	}
+	m_batch.resize(m_rebuild.size());
+	for (size_t lane = 0; lane < m_rebuild.size(); lane++) {
+		auto slot = m_rebuild[lane];
+		if (m_moved[slot]) {
+			m_batch.set(lane, glm::mix(m_previousPositions[slot], m_positions[slot], alpha),
+				glm::slerp(m_previousOrientations[slot], m_orientations[slot], alpha),
+				glm::mix(m_previousScales[slot], m_scales[slot], alpha), m_centers[slot]);
+		}
+		else {
+			m_batch.set(lane, m_positions[slot], m_orientations[slot], m_scales[slot], m_centers[slot]);
+		}
+	}
+	// Local matrices depend on nothing but their own slot, so they are composed in one batch.
+	composeTransforms(m_batch.columns(), m_baseTransforms.data(), m_rebuild.data(), m_locals.data());
+
+	// Every world matrix in a dirty node's subtree is out of date, and nothing else is. In slot
+	// order, a dirty node inside a subtree already rebuilt is skipped; any other dirty node's
+	// parent is either clean or was rebuilt earlier, so its world matrix is ready.
+	std::sort(m_rebuild.begin(), m_rebuild.end());
+	size_t rebuilt = 0;
+	size_t rebuiltEnd = 0;
+	for (auto first : m_rebuild) {
+		if (first < rebuiltEnd) {
+			continue;
+		}
+		rebuiltEnd = first + m_subtreeSizes[first];
+		for (auto slot = first; slot < rebuiltEnd; slot++) {
+			auto parent = m_parents[slot];
+			m_worlds[slot] = parent == NO_PARENT ? m_locals[slot] : m_worlds[parent] * m_locals[slot];
+		}
+		rebuilt += rebuiltEnd - first;
+	}
+	for (auto slot : m_rebuild) {
+		m_dirty[slot] = 0;
+	}
+	m_rebuild.clear();
+	return rebuilt;
+}
@@ -0,0 +1,39 @@
+#include "World.h"
+
+World& World::instance() {
+	static World world;
+	return world;
+}
+
+Entity World::clone(Entity root) {
+	auto copy = transforms.clone(root);
+	// The copies occupy the same relative slots as the originals.
+	auto from = transforms.slotOf(root);
+	auto to = transforms.slotOf(copy);
+	auto count = transforms.subtreeSizeAt(from);
+	for (size_t i = 0; i < count; i++) {
+		auto original = transforms.entityAt(from + i);
+		auto duplicate = transforms.entityAt(to + i);
+		if (auto renderable = renderables.find(original)) {
+			renderables.insert(duplicate, *renderable);
+		}
+		if (bodies.contains(original)) {
+			bodies.insert(duplicate, bodies.get(original));
+		}
+	}
+	return copy;
+}
+
+void World::destroy(Entity root) {
+	auto first = transforms.slotOf(root);
+	auto count = transforms.subtreeSizeAt(first);
+	for (auto slot = first; slot < first + count; slot++) {
+		auto entity = transforms.entityAt(slot);
+		renderables.remove(entity);
+		bodies.remove(entity);
+		animations.remove(entity);
+		statics.remove(entity);
+		broadphase.remove(entity);
+	}
+	transforms.destroy(root);
+}
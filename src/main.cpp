@@ -16,26 +16,31 @@ We now transform local space vertices to clip space using uniform matrices in th
 #include <math.h>
 
 #include "AssimpImport.h"
+#include "ModelRegistry.h"
+#include "TextureService.h"
+#include "TextureResidency.h"
 #include "Mesh3D.h"
 #include "Object3D.h"
+#include "RenderQueue.h"
 #include "Animator.h"
 #include "ShaderProgram.h"
+#include "LightManager.h"
+#include "Camera.h"
+#include "GLState.h"
+#include "World.h"
+#include "Physics.h"
+#include "Collision.h"
+#include "FixedTimestep.h"
 #include <SFML/Window/Event.hpp>
 #include <SFML/Window/Window.hpp>
 #include "TranslationAnimation.h"
-
-// Constant to set max point lights
-const int MAX_POINT_LIGHTS = 20;
-int currentPointLights;
-
-// Constant to set max spotlights
-const int MAX_SPOTLIGHTS = 10;
-int currentSpotLights;
+#include "RotationAnimation.h"
 
 struct Scene {
 	ShaderProgram program;
+	LightManager lights;
+	ModelRegistry models;
 	std::vector<Object3D> objects;
-	std::vector<Animator> animators;
 };
 
 /**
@@ -45,7 +50,8 @@ ShaderProgram phongLightingShader() {
 	ShaderProgram shader;
 	try {
 		// These shaders are INCOMPLETE.
-		shader.load("shaders/light_perspective.vert", "shaders/lighting.frag");
+		// Everything is drawn through RenderQueue, so the model matrix is an attribute.
+		shader.load("shaders/light_perspective_instanced.vert", "shaders/lighting.frag");
 	}
 	catch (std::runtime_error& e) {
 		std::cout << "ERROR: " << e.what() << std::endl;
@@ -55,122 +61,130 @@ ShaderProgram phongLightingShader() {
 }
 
 
+/**
+ * @brief The linear value of a color picked in sRGB. The framebuffer encodes what is written to
+ * it as sRGB, and the scene's light and clear colors were tuned by eye before it did, so they
+ * are converted to keep the scene looking as it was.
+ */
+glm::vec3 linearColor(glm::vec3 srgb) {
+	return glm::vec3(std::pow(srgb.x, 2.2f), std::pow(srgb.y, 2.2f), std::pow(srgb.z, 2.2f));
+}
+
+
 /**
 * @brief Initializes Phong lighting shader
 */
-void phongInit(ShaderProgram &program, float shininess) {
+void phongInit(ShaderProgram &program, LightManager& lights, float shininess) {
 	program.activate();
 	program.setUniform("material.shininess", shininess);
-	program.setUniform("numPointLights", 0); // Modify when point lights are added
-	program.setUniform("numSpotLights", 0); // Modify when spotlights are added
+	// The light counts start at 0 in the light buffer and grow as lights are added.
+	lights.attach(program);
 }
 
 
 /**
 * @brief Adds directional lighting to the scene using Phong lighting shader
 */
-void addDirectionalLight(ShaderProgram &program, glm::vec3 direction, glm::vec3 ambient, 
+void addDirectionalLight(LightManager& lights, glm::vec3 direction, glm::vec3 ambient, 
 	glm::vec3 diffuse, glm::vec3 specular) {
-	program.setUniform("dirLight.direction", direction);
-	program.setUniform("dirLight.ambient", ambient);
-	program.setUniform("dirLight.diffuse", diffuse);
-	program.setUniform("dirLight.specular", specular);
+	DirectionalLight light{};
+	light.direction = direction;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	lights.setDirectionalLight(light);
 }
 
 /**
 * @brief Sets directional lighting to daytime
 */
-void setToDayTime(ShaderProgram& program) {
+void setToDayTime(LightManager& lights) {
 	// clear color sets background
 	// source: https://registry.khronos.org/OpenGL-Refpages/gl4/html/glClearColor.xhtml
-	glClearColor(0.68, 0.85, 0.9, 1);
+	glm::vec3 sky = linearColor(glm::vec3(0.68, 0.85, 0.9));
+	glClearColor(sky.x, sky.y, sky.z, 1);
 	glm::vec3 direction = glm::vec3(0, -1, 0);
-	glm::vec3 ambientDir = glm::vec3(.3, .3, .255);
-	glm::vec3 diffuseDir = glm::vec3(1, 1, .85);
-	glm::vec3 specularDir = glm::vec3(.3, .3, .255);
-	addDirectionalLight(program, direction, ambientDir, diffuseDir, specularDir);
+	glm::vec3 ambientDir = linearColor(glm::vec3(.3, .3, .255));
+	glm::vec3 diffuseDir = linearColor(glm::vec3(1, 1, .85));
+	glm::vec3 specularDir = linearColor(glm::vec3(.3, .3, .255));
+	addDirectionalLight(lights, direction, ambientDir, diffuseDir, specularDir);
 }
 
 /**
 * @brief Sets directional lighting to night lighting
 */
-void setToNightTime(ShaderProgram& program) {
+void setToNightTime(LightManager& lights) {
 	glClearColor(0, 0, 0, 1);
 	glm::vec3 direction = glm::vec3(0, -1, 0);
-	glm::vec3 ambientDir = glm::vec3(.01, .01, .01);
-	glm::vec3 diffuseDir = glm::vec3(0, 0, 0);
-	glm::vec3 specularDir = glm::vec3(.03, .03, .03);
-	addDirectionalLight(program, direction, ambientDir, diffuseDir, specularDir);
+	glm::vec3 ambientDir = linearColor(glm::vec3(.01, .01, .01));
+	glm::vec3 diffuseDir = linearColor(glm::vec3(0, 0, 0));
+	glm::vec3 specularDir = linearColor(glm::vec3(.03, .03, .03));
+	addDirectionalLight(lights, direction, ambientDir, diffuseDir, specularDir);
 }
 
 
 /**
 * @brief Adds a point light to the scene using Phong lighting shader and attenuation
 */
-void addPointLight(ShaderProgram& program, glm::vec3 position, float constant,
+void addPointLight(LightManager& lights, glm::vec3 position, float constant,
 float linear, float quadratic, glm::vec3 ambient, glm::vec3 diffuse,
 glm::vec3 specular, int pointLightIndex) {	
 	//DONE: set some sort of warning when out of bounds.
-	if (pointLightIndex >= MAX_POINT_LIGHTS || pointLightIndex < 0) {
+	if (pointLightIndex >= static_cast<int>(MAX_POINT_LIGHTS) || pointLightIndex < 0) {
 		std::cerr << "Point light index out of bounds. You may see unusual results in your lighting." << std::endl;
 		return;
 	}
 
-	//modify the amount of spot lights on the scene if the new index hits the current array size
-	if(pointLightIndex >= currentPointLights)
-		program.setUniform("numPointLights", pointLightIndex + 1);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].position", position);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].constant", constant);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].linear", linear);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].quadratic", quadratic);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].ambient", ambient);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].diffuse", diffuse);
-	program.setUniform("pointLights[" + std::to_string(pointLightIndex) + "].specular", specular);
+	// The light manager extends the number of point lights to include this one.
+	PointLight light{};
+	light.position = position;
+	light.constant = constant;
+	light.linear = linear;
+	light.quadratic = quadratic;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	lights.setPointLight(pointLightIndex, light);
 }
 
 
 /**
 * @brief Adds a spotlight to the scene using Phong lighting shader, attenuation, and spotlight intensity
 */
-void addSpotLight(ShaderProgram& program, glm::vec3 position, glm::vec3 direction, float cutOff, float outerCutOff, float constant,
+void addSpotLight(LightManager& lights, glm::vec3 position, glm::vec3 direction, float cutOff, float outerCutOff, float constant,
 	float linear, float quadratic, glm::vec3 ambient, glm::vec3 diffuse,
 	glm::vec3 specular, int spotLightIndex) {
-	if (spotLightIndex >= MAX_SPOTLIGHTS || spotLightIndex < 0) {
+	if (spotLightIndex >= static_cast<int>(MAX_SPOTLIGHTS) || spotLightIndex < 0) {
 		std::cerr << "Spotlight index out of bounds. You may see unusual results in your lighting." << std::endl;
 		return;
 	}
 
-	//modify the amount of spotlights on the scene if the new index hits the current array size
-	if (spotLightIndex >= currentPointLights)
-		program.setUniform("numSpotLights", spotLightIndex + 1);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].position", position);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].direction", direction);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].cutOff", cutOff);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].outerCutOff", outerCutOff);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].constant", constant);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].linear", linear);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].quadratic", quadratic);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].ambient", ambient);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].diffuse", diffuse);
-	program.setUniform("spotLights[" + std::to_string(spotLightIndex) + "].specular", specular);
+	// The light manager extends the number of spotlights to include this one.
+	SpotLight light{};
+	light.position = position;
+	light.direction = direction;
+	light.cutOff = cutOff;
+	light.outerCutOff = outerCutOff;
+	light.constant = constant;
+	light.linear = linear;
+	light.quadratic = quadratic;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	lights.setSpotLight(spotLightIndex, light);
 }
 
-void moveFlashLight(ShaderProgram& program, glm::vec3 position, glm::vec3 direction) {
+void moveFlashLight(LightManager& lights, glm::vec3 position, glm::vec3 direction) {
 	//position -= glm::vec3(0, 2, 0);
-	program.setUniform("spotLights[0].position", position);
-	program.setUniform("spotLights[0].direction", direction);
+	lights.moveSpotLight(0, position, direction);
 }
 
-void toggleFlashLight(ShaderProgram& program, bool toggledOn) {
+void toggleFlashLight(LightManager& lights, bool toggledOn) {
 	if (toggledOn) {
-		program.setUniform("spotLights[0].ambient", glm::vec3(1, 1, 1));
-		program.setUniform("spotLights[0].diffuse", glm::vec3(0.8, 0.8, 0.8));
-		program.setUniform("spotLights[0].specular", glm::vec3(1, 1, 1));
+		lights.setSpotLightColor(0, linearColor(glm::vec3(1, 1, 1)), linearColor(glm::vec3(0.8, 0.8, 0.8)), linearColor(glm::vec3(1, 1, 1)));
 		return;
 	}
-	program.setUniform("spotLights[0].ambient", glm::vec3(0, 0, 0));
-	program.setUniform("spotLights[0].diffuse", glm::vec3(0, 0, 0));
-	program.setUniform("spotLights[0].specular", glm::vec3(0, 0, 0));
+	lights.setSpotLightColor(0, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
 }
 
 
@@ -192,10 +206,8 @@ ShaderProgram texturingShader() {
 /**
  * @brief Loads an image from the given path into an OpenGL texture.
  */
-Texture loadTexture(const std::filesystem::path& path, const std::string& samplerName = "material.baseTexture") {
-	StbImage i;
-	i.loadFromFile(path.string());
-	return Texture::loadImage(i, samplerName);
+TextureBinding loadTexture(const std::filesystem::path& path, const std::string& samplerName = "material.baseTexture") {
+	return TextureService::instance().load(path, samplerName);
 }
 
 const int TOTAL_ROCK_MAX = 100; //needed a global rock maximum since it is accessed in 2 places
@@ -213,6 +225,8 @@ void throwRock(Scene& scene, glm::vec3 position, glm::vec3 direction, int& rockC
 	auto& rock = scene.objects[rockCount + 2];
 	rock.move(position - ROCK_DISPLACEMENT);
 	rock.setVelocity(direction * glm::vec3(50,50,50));
+	// Rocks waiting to be thrown all sit in one place, so only thrown ones collide.
+	rock.setCollidable(true);
 	//TODO: Implement throwing physics
 
 	//remove that rock
@@ -225,19 +239,28 @@ void throwRock(Scene& scene, glm::vec3 position, glm::vec3 direction, int& rockC
 Scene mainScene() {
 	Scene scene{ phongLightingShader() };
 
+	// Start importing every model and decoding the floor textures on worker threads; the GL
+	// thread uploads them as the scene below asks for them.
+	scene.models.request("models/tree/scene.gltf", true);
+	scene.models.request("models/rock/scene.gltf", true);
+	scene.models.request("models/rat/street_rat_4k.gltf", true);
+	scene.models.request("models/monster/scene.gltf", true);
+	TextureService::instance().request("models/grass/grass01.jpg", TextureRole::BaseColor);
+	TextureService::instance().request("models/grass/grass01_s.jpg", TextureRole::Specular);
+
 	// grass for the ground
-	std::vector<Texture> textures = {
+	std::vector<TextureBinding> textures = {
 		loadTexture("models/grass/grass01.jpg", "material.baseTexture"),
-		loadTexture("models/grass/grass01_n.jpg", "material.normalMap"),
 		loadTexture("models/grass/grass01_s.jpg", "material.specularMap")
 	};
-	auto mesh = Mesh3D::square(textures);
-	auto floor = Object3D(std::vector<Mesh3D>{mesh});
-	// physics professors would hate me. Set mass to 0. Don't hate the developer, hate the game.
-	floor.setMass(0);
+	std::vector<Mesh3D> floorMeshes;
+	floorMeshes.push_back(Mesh3D::square(textures));
+	auto floor = Object3D(std::move(floorMeshes));
 	floor.grow(glm::vec3(5, 5, 5));
 	floor.move(glm::vec3(0, 0, 0));
 	floor.rotate(glm::vec3(-M_PI / 2, 0, 0));
+	// The scenery never moves once placed, so physics skips it and its bounds are baked.
+	floor.setMotion(Motion::Static);
 
 
 	//Trees
@@ -246,17 +269,20 @@ Scene mainScene() {
 	// Object3D does not have a default constructor, so I cannot initialize the vector size to TREE_COUNT
 	// and perform a range based for loop. This is the work-around so that we do not call any default 
 	// constructors that don't exist.
-	std::vector<Object3D> trees = { assimpLoad("models/tree/scene.gltf", true) };
-	trees.back().setMass(0);
+	std::vector<Object3D> trees;
+	trees.push_back(scene.models.instantiate("models/tree/scene.gltf", true));
 	trees.back().grow(glm::vec3(10, 10, 10));
 	trees.back().move(treePos);
+	trees.back().setMotion(Motion::Static);
+	trees.back().setCollidable(true);
 	
 
 	for (int i = 1; i < TREE_COUNT; i++) {
-		trees.emplace_back(assimpLoad("models/tree/scene.gltf", true));
-		trees.back().setMass(0);
+		trees.emplace_back(scene.models.instantiate("models/tree/scene.gltf", true));
 		trees.back().grow(glm::vec3(10, 10, 10));
 		trees.back().move(glm::vec3(treePos.x + 20, treePos.y, treePos.z));
+		trees.back().setMotion(Motion::Static);
+		trees.back().setCollidable(true);
 		
 		treePos += glm::vec3(20, 0, 0);
 		if (treePos.x >= 100) {
@@ -265,12 +291,13 @@ Scene mainScene() {
 	}
 
 	//rocks
-	std::vector<Object3D> rocks = { assimpLoad("models/rock/scene.gltf", true) };
+	std::vector<Object3D> rocks;
+	rocks.push_back(scene.models.instantiate("models/rock/scene.gltf", true));
 	rocks.back().grow(glm::vec3(0.3, 0.3, 0.3));
 	rocks.back().move(ROCK_DISPLACEMENT);
 	rocks.back().setMass(ROCK_MASS);
 	for (int i = 1; i < TOTAL_ROCK_MAX; i++) {
-		rocks.emplace_back(assimpLoad("models/rock/scene.gltf", true));
+		rocks.emplace_back(scene.models.instantiate("models/rock/scene.gltf", true));
 		rocks.back().grow(glm::vec3(0.3, 0.3, 0.3));
 		//the rock origin is (0, -0.7, 0). Preload them below the map to improve framerate.
 		rocks.back().move(ROCK_DISPLACEMENT);
@@ -278,35 +305,39 @@ Scene mainScene() {
 	}
 	
 	//rat
-	auto rat = assimpLoad("models/rat/street_rat_4k.gltf", true);
-	rat.setMass(0);
+	auto rat = scene.models.instantiate("models/rat/street_rat_4k.gltf", true);
+	// Only its animation moves the rat.
+	rat.setMotion(Motion::Kinematic);
 	rat.grow(glm::vec3(30, 30, 30));
-	rat.move(glm::vec3(0.2, -1.5, 0));
+	// On the floor, where the simulation used to snap it before it was kinematic.
+	rat.move(glm::vec3(0.2, 0, 0));
+	rat.setCollidable(true);
+	// Animators belong to the entity they animate, and entities stay valid wherever the object goes.
+	Animator animRat;
+	animRat.addAnimation(std::make_unique<TranslationAnimation>(rat.getEntity(), 30, glm::vec3(0, 10, 0)));
+	World::instance().animations.insert(rat.getEntity(), AnimationTarget{ std::move(animRat) });
 	
 	//monster
-	auto monster = assimpLoad("models/monster/scene.gltf", true);
+	auto monster = scene.models.instantiate("models/monster/scene.gltf", true);
 	monster.grow(glm::vec3(4.5, 4.5, 4.5));
 	monster.move(glm::vec3(13, -1.5, 33));
+	monster.setCollidable(true);
 
 	//Initialize light values
-	phongInit(scene.program, 32.0);
+	phongInit(scene.program, scene.lights, 32.0);
 
 	// set time of day by adding directional light
-	//setToDayTime(scene.program);
-	setToNightTime(scene.program);
+	//setToDayTime(scene.lights);
+	setToNightTime(scene.lights);
 
 	scene.objects.push_back(std::move(floor)); //pos 0
 	scene.objects.push_back(std::move(rat)); //pos 1
 	scene.objects.push_back(std::move(monster)); //pos 2
-	for (Object3D r : rocks) //start at position 3 (desired index + 2)
+	for (Object3D& r : rocks) //start at position 3 (desired index + 2)
 		scene.objects.push_back(std::move(r));
-	for (Object3D t : trees)
+	for (Object3D& t : trees)
 		scene.objects.push_back(std::move(t));
 
-	Animator animRat;
-	animRat.addAnimation(std::make_unique<TranslationAnimation>(scene.objects[1], 30, glm::vec3(0, 10, 0)));
-
-	scene.animators.push_back(std::move(animRat));
 	return scene;
 }
 
@@ -323,52 +354,57 @@ Scene lifeOfPi() {
 	// This scene is more complicated; it has child objects, as well as animators.
 	Scene scene{ phongLightingShader() };
 
-	auto boat = assimpLoad("models/boat/boat.fbx", true);
-	boat.move(glm::vec3(0, -0.7, 0));
+	scene.models.request("models/boat/boat.fbx", true);
+	scene.models.request("models/tiger/scene.gltf", true);
+	scene.models.finishLoading();
+
+	auto boat = scene.models.instantiate("models/boat/boat.fbx", true);
+	// Both are moved only by their animations.
+	boat.setMotion(Motion::Kinematic);
+	// At the heights the simulation used to snap them to before they were kinematic: the boat
+	// on the floor, and the tiger at the boat's origin height.
 	boat.grow(glm::vec3(0.01, 0.01, 0.01));
-	auto tiger = assimpLoad("models/tiger/scene.gltf", true);
-	tiger.move(glm::vec3(0, -5, 10));
+	auto tiger = scene.models.instantiate("models/tiger/scene.gltf", true);
+	tiger.setMotion(Motion::Kinematic);
+	tiger.move(glm::vec3(0, 0, 10));
+
+	// Animations refer to entities, which stay valid when the objects are moved: the tiger into
+	// the boat, and the boat into the scene's list. Each animator belongs to the entity it animates.
+	Animator animBoat;
+	animBoat.addAnimation(std::make_unique<RotationAnimation>(boat.getEntity(), 10, glm::vec3(0, 2 * M_PI, 0)));
+	World::instance().animations.insert(boat.getEntity(), AnimationTarget{ std::move(animBoat) });
+	Animator animTiger;
+	animTiger.addAnimation(std::make_unique<RotationAnimation>(tiger.getEntity(), 10, glm::vec3(0, 0, 2 * M_PI)));
+	World::instance().animations.insert(tiger.getEntity(), AnimationTarget{ std::move(animTiger) });
+
 	// Move the tiger to be a child of the boat.
 	boat.addChild(std::move(tiger));
 
 
 	//Initialize light values
-	phongInit(scene.program, 32.0);
+	phongInit(scene.program, scene.lights, 32.0);
 
 	// Add directional light (midnight)
 	glm::vec3 direction = glm::vec3(10, -1, 0);
-	glm::vec3 ambientDir = glm::vec3(0.05, 0.05, 0.05);
-	glm::vec3 diffuseDir = glm::vec3(0, 0, 0);
-	glm::vec3 specularDir = glm::vec3(0.05, 0.05, 0.05);
-	addDirectionalLight(scene.program, direction, ambientDir, diffuseDir, specularDir);
+	glm::vec3 ambientDir = linearColor(glm::vec3(0.05, 0.05, 0.05));
+	glm::vec3 diffuseDir = linearColor(glm::vec3(0, 0, 0));
+	glm::vec3 specularDir = linearColor(glm::vec3(0.05, 0.05, 0.05));
+	addDirectionalLight(scene.lights, direction, ambientDir, diffuseDir, specularDir);
 
 	// Add a point light
 	glm::vec3 position = glm::vec3(0, 20, 0);
 	float constant = 1.0;
 	float linear = 0.09;
 	float quadratic = 0.032;
-	glm::vec3 ambientPoint = glm::vec3(0, 0, 0);
-	glm::vec3 diffusePoint = glm::vec3(.8, .8, .6);
-	glm::vec3 specularPoint = glm::vec3(1, 1, .75);
-	addPointLight(scene.program, position, constant, linear, quadratic, ambientPoint, diffusePoint, specularPoint, 0);
+	glm::vec3 ambientPoint = linearColor(glm::vec3(0, 0, 0));
+	glm::vec3 diffusePoint = linearColor(glm::vec3(.8, .8, .6));
+	glm::vec3 specularPoint = linearColor(glm::vec3(1, 1, .75));
+	addPointLight(scene.lights, position, constant, linear, quadratic, ambientPoint, diffusePoint, specularPoint, 0);
 
 	// Move the boat into the scene list.
 	scene.objects.push_back(std::move(boat));
 
-	// We want these animations to referenced the *moved* objects, which are no longer
-	// in the variables named "tiger" and "boat". "boat" is now in the "objects" list at
-	// index 0, and "tiger" is the index-1 child of the boat.
-	Animator animBoat;
-	animBoat.addAnimation(std::make_unique<RotationAnimation>(scene.objects[0], 10, glm::vec3(0, 2 * M_PI, 0)));
-	Animator animTiger;
-	animTiger.addAnimation(std::make_unique<RotationAnimation>(scene.objects[0].getChild(1), 10, glm::vec3(0, 0, 2 * M_PI)));
-
-	// The Animators will be destroyed when leaving this function, so we move them into
-	// a list to be returned.
-	scene.animators.push_back(std::move(animBoat));
-	scene.animators.push_back(std::move(animTiger));
-
-	// Transfer ownership of the objects and animators back to the main.
+	// Transfer ownership of the objects back to the main.
 	return scene;
 }
 
@@ -385,10 +421,16 @@ int main() {
 	settings.antialiasingLevel = 2;  // Request 2 levels of antialiasing
 	settings.majorVersion = 3;
 	settings.minorVersion = 3;
+	settings.sRgbCapable = true; // Base color textures are sRGB, so the framebuffer must be too
 	sf::Window window(sf::VideoMode{ 1800, 1200 }, "Michael's Scene", sf::Style::Resize | sf::Style::Close, settings);
 
 	gladLoadGL();
-	glEnable(GL_DEPTH_TEST);
+	GLState::instance().setDepthTest(true);
+	// Everything written to the framebuffer is encoded to sRGB, so the clear colors and light
+	// values are given to GL as linear, through linearColor.
+	glEnable(GL_FRAMEBUFFER_SRGB);
+	TextureService::instance().detectCapabilities();
+	TextureResidency::instance().setBudget(size_t(256) << 20);
 
 	// Inintialize scene objects.
 	auto myScene = mainScene();
@@ -397,53 +439,57 @@ int main() {
 
 	// Activate the shader program.
 	myScene.program.activate();
-
-	// Set up the view and projection matrices.
-	glm::vec3 cameraPos = glm::vec3(0, 10, 0); //The player is 10 tall. 
-	glm::vec3 cameraFront = glm::vec3(0, 0, -1);
-	glm::vec3 cameraUp = glm::vec3(0, 1, 0);
-	glm::mat4 camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-	glm::mat4 perspective = glm::perspective(glm::radians(45.0), static_cast<double>(window.getSize().x) / window.getSize().y, 0.1, 100.0);
-	myScene.program.setUniform("view", camera);
-	myScene.program.setUniform("projection", perspective);
-	myScene.program.setUniform("cameraPos", cameraPos);
+	RenderQueue queue;
+	CullingStats culling;
+	size_t transformsRebuilt = 0;
+	size_t collisionCandidates = 0;
+	// Physics and animations advance in fixed steps, however fast the frames come. A slower
+	// rate is cheaper, and drawing between the last two steps keeps it smooth; a frame may run
+	// up to MAX_SUBSTEPS steps to catch up before the simulation slows down instead.
+	const float SIMULATION_RATE = 60;
+	const int MAX_SUBSTEPS = 5;
+	FixedTimestep timestep(SIMULATION_RATE, MAX_SUBSTEPS);
+
+	// Set up the camera. Its view and projection matrices live in a uniform buffer that every
+	// program with a Camera block reads; update() rebuilds and uploads them once per frame.
+	Camera camera(glm::vec3(0, 10, 0), 45, static_cast<float>(window.getSize().x) / window.getSize().y, 0.1, 100); //The player is 10 tall. 
+	camera.attach(myScene.program);
 
 	// Ready, set, go!
 	bool running = true;
 	sf::Clock c;
 	auto last = c.getElapsedTime();
+	auto lastReport = last;
+	int framesSinceReport = 0;
 
 	// Start the animators.
-	for (auto& anim : myScene.animators) {
-		anim.start();
+	auto& world = World::instance();
+	for (auto& target : world.animations.components()) {
+		target.animator.start();
 	}
 
 	float sensitivity = 0.1;
 
 	//create the character's flashlight. also have a boolean to turn it off
-	glm::vec3 flashlightPos = cameraPos;
-	glm::vec3 flashlightDir = cameraFront;
+	glm::vec3 flashlightPos = camera.getPosition();
+	glm::vec3 flashlightDir = camera.getFront();
 	float cutOff = std::cos(glm::radians(12.5));
 	float outerCutOff = std::cos(glm::radians(17.5));
 	float constant = 1.0;
 	float linear = 0.045;
 	float quadratic = 0.0075;
-	glm::vec3 flashlightAmbient = glm::vec3(1, 1, 1);
-	glm::vec3 flashlightDiffuse = glm::vec3(0.8, 0.8, 0.8);
-	glm::vec3 flashlightSpecular = glm::vec3(1, 1, 1);
-	addSpotLight(myScene.program, flashlightPos, flashlightDir, cutOff, outerCutOff, constant, linear, quadratic, flashlightAmbient, flashlightDiffuse, flashlightSpecular, 0);
+	glm::vec3 flashlightAmbient = linearColor(glm::vec3(1, 1, 1));
+	glm::vec3 flashlightDiffuse = linearColor(glm::vec3(0.8, 0.8, 0.8));
+	glm::vec3 flashlightSpecular = linearColor(glm::vec3(1, 1, 1));
+	addSpotLight(myScene.lights, flashlightPos, flashlightDir, cutOff, outerCutOff, constant, linear, quadratic, flashlightAmbient, flashlightDiffuse, flashlightSpecular, 0);
 	bool flashlightToggled = false;
-	toggleFlashLight(myScene.program, flashlightToggled);
+	toggleFlashLight(myScene.lights, flashlightToggled);
 	
 
 	// initial x and y postions of the mouse. Window size divided by 2 (center of screen)
 	const float X0 = static_cast<float>(window.getSize().x / 2);
 	const float Y0 = static_cast<float>(window.getSize().y / 2);
 
-	// initialize yaw and pitch. yaw is -90 to look in the negative z direction
-	float yaw = -90.0;
-	float pitch = 0.0;
-
 	// use setPosition to center the mouse in the screen
 	// sfml documentation for setPosition: https://www.sfml-dev.org/documentation/2.6.1/classsf_1_1Mouse.php
 	sf::Mouse::setPosition(sf::Vector2i(window.getSize().x / 2, window.getSize().y / 2), window);
@@ -468,14 +514,14 @@ int main() {
 				
 				case(sf::Keyboard::Key::F):
 					flashlightToggled = !flashlightToggled;
-					toggleFlashLight(myScene.program, flashlightToggled);
+					toggleFlashLight(myScene.lights, flashlightToggled);
 					break;
 				
 				}
 			}
 			else if (ev.type == sf::Event::MouseButtonPressed) {
 				if (ev.mouseButton.button == sf::Mouse::Button::Left)
-					throwRock(myScene, cameraPos, glm::normalize(cameraFront), rockCount);
+					throwRock(myScene, camera.getPosition(), camera.getFront(), rockCount);
 			}
 			
 
@@ -494,31 +540,10 @@ int main() {
 				deltaX *= sensitivity;
 				deltaY *= sensitivity;
 
-				// Add the change to the yaw and pitch of the camera
-				yaw += deltaX;
-				pitch += deltaY;
-
-				// we don't want the y axis to pass 90 degrees in either direction. If we do that, it will
-				// mess up the math on the other axes.
-				if (pitch > 89.0)
-					pitch = 89.0;
-				if (pitch < -89.0)
-					pitch = -89.0;
-
-				// Update the cameraFront to implemnet Euler angles for our direction
-				glm::vec3 direction;
-				direction.x = std::cos(glm::radians(yaw)) * std::cos(glm::radians(pitch));
-				direction.y = sin(glm::radians(pitch));
-				direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-				cameraFront = glm::normalize(direction);
-
-				// Now we call glm::lookAt to update the camera
-				camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-				myScene.program.setUniform("view", camera);
-
-				//move the flashlight with it
-				moveFlashLight(myScene.program, cameraPos, cameraFront);
-				
+				// Add the change to the yaw and pitch of the camera. The camera keeps the pitch
+				// within 89 degrees either way, and rebuilds its view once the frame's input is in.
+				camera.turn(deltaX, deltaY);
+
 				//now reset the mouse position back to the center of the window
 				sf::Mouse::setPosition(sf::Vector2i(window.getSize().x / 2, window.getSize().y / 2), window);
 			}
@@ -526,14 +551,37 @@ int main() {
 		// moved framerate calculation to the top so that I can use it for movement
 		auto now = c.getElapsedTime();
 		auto diff = now - last;
-		std::cout << 1 / diff.asSeconds() << " FPS " << std::endl;
 		last = now;
+		// Report about once a second rather than every frame, which would slow the frames it times.
+		// The GL call counts are averaged over the second; the rest are from the last frame.
+		framesSinceReport++;
+		float sinceReport = (now - lastReport).asSeconds();
+		if (sinceReport >= 1) {
+			auto& glCalls = GLState::instance().stats();
+			std::cout << framesSinceReport / sinceReport << " FPS, " << culling.visible
+				<< " objects visible, " << culling.culled << " culled, " << glCalls.issued / framesSinceReport
+				<< " GL state calls issued and " << glCalls.elided / framesSinceReport << " elided per frame, "
+				<< transformsRebuilt << " transforms rebuilt, " << collisionCandidates << " collision candidates\n";
+			GLState::instance().resetStats();
+			framesSinceReport = 0;
+			lastReport = now;
+		}
 		//calculate speed for movement
 		float movementSpeed = 8.5 * diff.asSeconds();
 		
-		//Tick each object
-		for (Object3D& o : myScene.objects) 
-			o.tick(diff.asSeconds());
+		// Run however many simulation steps this frame's time adds up to.
+		int steps = timestep.advance(diff.asSeconds());
+		for (int step = 0; step < steps; step++) {
+			world.transforms.beginStep();
+			//Tick every physics body
+			tickPhysics(world, timestep.step());
+			for (auto& target : world.animations.components()) {
+				target.animator.tick(timestep.step());
+			}
+			// The pairs of colliders close enough to be touching. Nothing responds to them yet.
+			collisionCandidates = findCollisionCandidates(world).size();
+			world.transforms.endStep();
+		}
 		
 			
 
@@ -545,6 +593,8 @@ int main() {
 		// since openGL's tutorial had x,y,z movement, I wanted only x,y movement. I realized to make it consisitent
 		// no matter where the character looks vertically, we have to normalize the vector before doing an operation 
 		// on it. (I actually came up with that on my own, my linear algebra brain works again!)
+		glm::vec3 cameraFront = camera.getFront();
+		glm::vec3 cameraUp = camera.getUp();
 		glm::vec3 frontXZ = glm::normalize(glm::vec3(cameraFront.x, 0, cameraFront.z));
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift))
 			movementSpeed *= 2.5;
@@ -553,52 +603,53 @@ int main() {
 			// just trial and error!)
 			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A)|| sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
 				movementSpeed /= 1.5;
-			cameraPos += movementSpeed * frontXZ;
-			camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-			myScene.program.setUniform("view", camera);
-			moveFlashLight(myScene.program, cameraPos, cameraFront);
+			camera.move(movementSpeed * frontXZ);
 		}
 		// had to move the 'S' case above the 'A' case to keep the movement logic consistent
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S)) {
 			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A) || sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
 				movementSpeed /= 1.5;
-			cameraPos -= movementSpeed * frontXZ;
-			camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-			myScene.program.setUniform("view", camera);
-			moveFlashLight(myScene.program, cameraPos, cameraFront);
+			camera.move(-movementSpeed * frontXZ);
 		}
 		//cross product of up and forward gives us position to the right
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A)) {
-			cameraPos -= glm::normalize(glm::cross(frontXZ, cameraUp)) * movementSpeed;
-			camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-			myScene.program.setUniform("view", camera);
-			moveFlashLight(myScene.program, cameraPos, cameraFront);
+			camera.move(-glm::normalize(glm::cross(frontXZ, cameraUp)) * movementSpeed);
 		}
 		
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) {
-			cameraPos += glm::normalize(glm::cross(frontXZ, cameraUp)) * movementSpeed;
-			camera = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-			myScene.program.setUniform("view", camera);
-			moveFlashLight(myScene.program, cameraPos, cameraFront);
+			camera.move(glm::normalize(glm::cross(frontXZ, cameraUp)) * movementSpeed);
 		}
 		
-		// Update the scene.
-		for (auto& anim : myScene.animators) {
-			anim.tick(diff.asSeconds());
+		// Rebuild the camera's matrices from this frame's input, and take the flashlight along.
+		if (camera.update()) {
+			moveFlashLight(myScene.lights, camera.getPosition(), camera.getFront());
 		}
 
+		// Rebuild the world matrices of whatever moved, and of everything attached to it, drawing
+		// what the last step moved between where it was and where it is.
+		transformsRebuilt = world.transforms.updateWorld(timestep.alpha());
+
 		// Clear the OpenGL "context".
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		// Render the scene objects.
-		for (auto& o : myScene.objects) {
-			o.render(myScene.program);
-		}
+		// Render the scene objects that are in view, sorted by state and front to back, one draw call per batch.
+		// Send whatever the lights changed this frame, in one upload.
+		myScene.lights.upload();
+		culling = CullingStats();
+		queue.setProgram(myScene.program);
+		queue.setViewer(camera.getPosition(), camera.getFarPlane());
+		Object3D::submitVisible(myScene.objects, queue, Frustum(camera.getViewProjection()), culling);
+		queue.render();
 		window.display();
+		// Shrink textures that are off screen if VRAM is over budget, and restore visible ones.
+		TextureResidency::instance().endFrame();
 
 
 		
 	}
 
+	// Textures uploaded ahead but never used would otherwise be deleted after the window and its
+	// GL context are gone.
+	TextureService::instance().clear();
 	return 0;
 }
 
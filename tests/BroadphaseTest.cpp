@@ -0,0 +1,197 @@
+#include "Broadphase.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+
+namespace {
+	struct Collider {
+		Entity entity;
+		Aabb box;
+		bool isStatic;
+		bool isInserted;
+	};
+
+	Aabb boxAround(const glm::vec3& center, const glm::vec3& halfExtent) {
+		Aabb box;
+		box.merge(center - halfExtent);
+		box.merge(center + halfExtent);
+		return box;
+	}
+
+	std::pair<uint32_t, uint32_t> ordered(Entity a, Entity b) {
+		return std::minmax(a.index, b.index);
+	}
+
+	/**
+	 * @brief Checks the pairs found against every pair of colliders tested one by one, and that
+	 * none is reported twice. Returns false after the first mismatch.
+	 */
+	bool checkAgainstBruteForce(Broadphase& broadphase, const std::vector<Collider>& colliders, int step) {
+		std::set<std::pair<uint32_t, uint32_t>> expected;
+		for (size_t i = 0; i < colliders.size(); i++) {
+			for (size_t j = i + 1; j < colliders.size(); j++) {
+				auto& a = colliders[i];
+				auto& b = colliders[j];
+				if (!a.isInserted || !b.isInserted || (a.isStatic && b.isStatic) || a.box.isEmpty() || b.box.isEmpty()) {
+					continue;
+				}
+				if (a.box.min.x <= b.box.max.x && b.box.min.x <= a.box.max.x && a.box.min.y <= b.box.max.y
+					&& b.box.min.y <= a.box.max.y && a.box.min.z <= b.box.max.z && b.box.min.z <= a.box.max.z) {
+					expected.insert(ordered(a.entity, b.entity));
+				}
+			}
+		}
+
+		auto& pairs = broadphase.findPairs();
+		std::set<std::pair<uint32_t, uint32_t>> found;
+		for (auto& pair : pairs) {
+			auto& first = colliders[pair.first.index];
+			auto& second = colliders[pair.second.index];
+			if (pair.first != first.entity || pair.second != second.entity) {
+				reportFailure(__FILE__, __LINE__, "a pair names an entity that is no longer a collider");
+				return false;
+			}
+			found.insert(ordered(pair.first, pair.second));
+		}
+		if (found.size() != pairs.size() || found != expected) {
+			std::ostringstream message;
+			message << "step " << step << ": found " << pairs.size() << " pairs (" << found.size()
+				<< " different), brute force finds " << expected.size();
+			reportFailure(__FILE__, __LINE__, message.str());
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Random moves, teleports, inserts, removes and changes of kind, in a space crowded
+	 * enough that many boxes overlap, with the pairs checked against brute force after every step.
+	 * Stretches of small moves, where the pairs are updated, alternate with stretches of moves
+	 * far enough that they are swept for instead.
+	 */
+	void testMatchesBruteForce() {
+		std::mt19937 random(11);
+		std::uniform_real_distribution<float> coordinate(-20, 20);
+		std::uniform_real_distribution<float> size(0.2f, 3);
+		std::uniform_real_distribution<float> nudge(-1, 1);
+		auto randomBox = [&]() {
+			return boxAround(glm::vec3(coordinate(random), coordinate(random), coordinate(random)),
+				glm::vec3(size(random), size(random), size(random)));
+		};
+
+		Broadphase broadphase;
+		std::vector<Collider> colliders;
+		for (uint32_t i = 0; i < 300; i++) {
+			colliders.push_back(Collider{ Entity{ i, 0 }, randomBox(), i % 4 == 0, i % 3 != 0 });
+			if (colliders.back().isInserted) {
+				broadphase.insert(colliders.back().entity, colliders.back().box, colliders.back().isStatic);
+			}
+		}
+		for (int step = 0; step < 600; step++) {
+			// Most steps only move boxes, which updates the pairs rather than rebuilding them.
+			for (int change = 0; change < (step % 10 == 0 ? 10 : 0); change++) {
+				auto& collider = colliders[random() % colliders.size()];
+				switch (random() % 8) {
+				case 0:
+					if (!collider.isInserted) {
+						broadphase.insert(collider.entity, collider.box, collider.isStatic);
+						collider.isInserted = true;
+					}
+					break;
+				case 1:
+					// Removing twice, or what was never inserted, does nothing.
+					broadphase.remove(collider.entity);
+					collider.isInserted = false;
+					break;
+				case 2:
+					// The entity is destroyed and its index reused by a new one.
+					broadphase.remove(collider.entity);
+					CHECK(!broadphase.contains(collider.entity));
+					collider.entity.generation++;
+					collider.box = randomBox();
+					broadphase.insert(collider.entity, collider.box, collider.isStatic);
+					collider.isInserted = true;
+					break;
+				case 3:
+					if (collider.isInserted) {
+						collider.isStatic = !collider.isStatic;
+						broadphase.insert(collider.entity, collider.box, collider.isStatic);
+					}
+					break;
+				case 4:
+					if (collider.isInserted && !collider.isStatic) {
+						collider.box = random() % 4 == 0 ? Aabb() : randomBox();
+						broadphase.insert(collider.entity, collider.box, false);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			float reach = (step / 50) % 2 == 0 ? 0.5f : 10.0f;
+			for (auto& collider : colliders) {
+				if (!collider.isStatic && !collider.box.isEmpty()) {
+					auto offset = glm::vec3(nudge(random), nudge(random), nudge(random)) * reach;
+					// Wrapped around, to keep the space as crowded as it started.
+					auto center = collider.box.center() + offset;
+					for (int axis = 0; axis < 3; axis++) {
+						if (std::abs(center[axis]) > 20) {
+							offset[axis] -= center[axis] > 0 ? 40 : -40;
+						}
+					}
+					collider.box.min += offset;
+					collider.box.max += offset;
+				}
+			}
+			broadphase.refresh([&](Entity entity) { return colliders[entity.index].box; });
+			if (!checkAgainstBruteForce(broadphase, colliders, step)) {
+				return;
+			}
+		}
+	}
+
+	void testTouchingAndStatic() {
+		Broadphase broadphase;
+		Entity a{ 0, 0 }, b{ 1, 0 }, c{ 2, 0 };
+		broadphase.insert(a, boxAround(glm::vec3(0), glm::vec3(1)), true);
+		broadphase.insert(b, boxAround(glm::vec3(3, 0, 0), glm::vec3(1)), true);
+		CHECK_EQUAL(broadphase.size(), size_t(2));
+		CHECK(broadphase.findPairs().empty());
+
+		// Boxes that only touch count as overlapping, from the rebuild and from the update alike.
+		broadphase.insert(c, boxAround(glm::vec3(0, 2, 0), glm::vec3(1)), false);
+		CHECK_EQUAL(broadphase.findPairs().size(), size_t(1));
+		broadphase.insert(c, boxAround(glm::vec3(0, 2.5f, 0), glm::vec3(1)), false);
+		CHECK(broadphase.findPairs().empty());
+		broadphase.insert(c, boxAround(glm::vec3(2, 2, 0), glm::vec3(1)), false);
+		auto& pairs = broadphase.findPairs();
+		CHECK_EQUAL(pairs.size(), size_t(2));
+
+		// Two static boxes are never paired, even once one of them was dynamic.
+		broadphase.insert(c, boxAround(glm::vec3(2, 2, 0), glm::vec3(1)), true);
+		CHECK(broadphase.findPairs().empty());
+		broadphase.insert(c, boxAround(glm::vec3(2, 2, 0), glm::vec3(1)), false);
+		CHECK_EQUAL(broadphase.findPairs().size(), size_t(2));
+		// Once a sweep finds nothing moving, the steps after it update the pairs instead, and a
+		// collider removed in between takes its pairs with it.
+		CHECK_EQUAL(broadphase.findPairs().size(), size_t(2));
+
+		broadphase.remove(a);
+		CHECK(!broadphase.contains(a));
+		CHECK_EQUAL(broadphase.size(), size_t(2));
+		auto& remaining = broadphase.findPairs();
+		CHECK_EQUAL(remaining.size(), size_t(1));
+		if (remaining.size() == 1) {
+			CHECK(ordered(remaining[0].first, remaining[0].second) == ordered(b, c));
+		}
+	}
+}
+
+int main() {
+	testTouchingAndStatic();
+	testMatchesBruteForce();
+	return finishChecks();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief The few assertions the test executables need. A failed check is reported with its
+ * location and counted rather than aborting, so one run shows every failure; finishChecks()
+ * turns the count into the exit status CTest looks at.
+ */
+
+inline int& checkFailures() {
+	static int failures = 0;
+	return failures;
+}
+
+inline void reportFailure(const char* file, int line, const std::string& message) {
+	checkFailures()++;
+	std::cerr << file << ":" << line << ": " << message << std::endl;
+}
+
+/**
+ * @brief Prints a summary and returns the exit status for main.
+ */
+inline int finishChecks() {
+	if (checkFailures() == 0) {
+		std::cout << "All checks passed" << std::endl;
+		return 0;
+	}
+	std::cerr << checkFailures() << " check(s) failed" << std::endl;
+	return 1;
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			reportFailure(__FILE__, __LINE__, "CHECK(" #condition ") failed"); \
+		} \
+	} while (false)
+
+#define CHECK_EQUAL(actual, expected) \
+	do { \
+		auto&& checkActual = (actual); \
+		auto&& checkExpected = (expected); \
+		if (!(checkActual == checkExpected)) { \
+			std::ostringstream checkMessage; \
+			checkMessage << #actual " is " << checkActual << ", expected " << checkExpected; \
+			reportFailure(__FILE__, __LINE__, checkMessage.str()); \
+		} \
+	} while (false)
+
+#define CHECK_NEAR(actual, expected, epsilon) \
+	do { \
+		double checkActual = (actual); \
+		double checkExpected = (expected); \
+		if (!(std::abs(checkActual - checkExpected) <= (epsilon))) { \
+			std::ostringstream checkMessage; \
+			checkMessage << #actual " is " << checkActual << ", expected " << checkExpected \
+				<< " within " << (epsilon); \
+			reportFailure(__FILE__, __LINE__, checkMessage.str()); \
+		} \
+	} while (false)
+
+#define CHECK_THROWS(expression, exception) \
+	do { \
+		bool checkThrew = false; \
+		try { \
+			(void)(expression); \
+		} \
+		catch (const exception&) { \
+			checkThrew = true; \
+		} \
+		if (!checkThrew) { \
+			reportFailure(__FILE__, __LINE__, #expression " did not throw " #exception); \
+		} \
+	} while (false)
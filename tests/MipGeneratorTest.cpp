@@ -0,0 +1,113 @@
+#include "MipGenerator.h"
+#include "Check.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+	/**
+	 * @brief The documented 2x2 box filter, written as plainly as possible: every channel of every
+	 * output pixel is (a + b + c + d + 2) >> 2, and a dimension of 1 repeats its only row or column.
+	 */
+	std::vector<uint8_t> referenceDownsample(const MipImage& source) {
+		int32_t width = std::max(source.width / 2, 1);
+		int32_t height = std::max(source.height / 2, 1);
+		std::vector<uint8_t> result(static_cast<size_t>(width) * height * source.channels);
+		auto at = [&](int32_t x, int32_t y, int32_t c) -> int32_t {
+			return source.pixels[(static_cast<size_t>(y) * source.width + x) * source.channels + c];
+		};
+		for (int32_t y = 0; y < height; y++) {
+			int32_t y0 = y * 2;
+			int32_t y1 = source.height > 1 ? y0 + 1 : y0;
+			for (int32_t x = 0; x < width; x++) {
+				int32_t x0 = x * 2;
+				int32_t x1 = source.width > 1 ? x0 + 1 : x0;
+				for (int32_t c = 0; c < source.channels; c++) {
+					int32_t sum = at(x0, y0, c) + at(x1, y0, c) + at(x0, y1, c) + at(x1, y1, c);
+					result[(static_cast<size_t>(y) * width + x) * source.channels + c] = static_cast<uint8_t>((sum + 2) >> 2);
+				}
+			}
+		}
+		return result;
+	}
+
+	std::vector<MipKernel> availableKernels() {
+		std::vector<MipKernel> kernels;
+		for (auto kernel : { MipKernel::Scalar, MipKernel::SSE2, MipKernel::AVX2 }) {
+			if (kernel <= bestMipKernel()) {
+				kernels.push_back(kernel);
+			}
+		}
+		return kernels;
+	}
+
+	/**
+	 * @brief Downsamples random pixels of the given shape with every kernel this CPU has, and
+	 * checks each against the reference byte for byte.
+	 */
+	void checkShape(std::mt19937& random, int32_t width, int32_t height, int32_t channels) {
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * channels);
+		for (auto& pixel : pixels) {
+			pixel = static_cast<uint8_t>(random());
+		}
+		MipImage source;
+		source.width = width;
+		source.height = height;
+		source.channels = channels;
+		source.pixels = pixels.data();
+
+		auto expected = referenceDownsample(source);
+		for (auto kernel : availableKernels()) {
+			auto result = downsampleMip(source, kernel);
+			if (result.storage != expected) {
+				std::ostringstream message;
+				message << "kernel " << static_cast<int>(kernel) << " differs from the reference at "
+					<< width << "x" << height << "x" << channels;
+				reportFailure(__FILE__, __LINE__, message.str());
+			}
+		}
+	}
+
+	void testOddAndEvenSizes() {
+		std::mt19937 random(7);
+		// Widths around every vector size, so each kernel's tail is exercised, plus 1 and 3.
+		for (int32_t channels = 1; channels <= 4; channels++) {
+			for (int32_t width : { 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 127, 129, 257 }) {
+				for (int32_t height : { 1, 2, 3, 5, 8, 13 }) {
+					checkShape(random, width, height, channels);
+				}
+			}
+		}
+	}
+
+	void testRandomSizes() {
+		std::mt19937 random(11);
+		for (int trial = 0; trial < 500; trial++) {
+			checkShape(random, 1 + random() % 300, 1 + random() % 40, 1 + random() % 4);
+		}
+	}
+
+	void testChainReachesOnePixel() {
+		std::vector<uint8_t> pixels(37 * 5 * 4, 200);
+		MipImage source;
+		source.width = 37;
+		source.height = 5;
+		source.channels = 4;
+		source.pixels = pixels.data();
+		for (auto kernel : availableKernels()) {
+			auto chain = generateMipChain(source, kernel);
+			CHECK_EQUAL(chain.size(), size_t(5));
+			CHECK_EQUAL(chain.back().width, 1);
+			CHECK_EQUAL(chain.back().height, 1);
+			// A flat image stays flat all the way down.
+			CHECK_EQUAL(static_cast<int>(chain.back().pixels[3]), 200);
+		}
+	}
+}
+
+int main() {
+	testOddAndEvenSizes();
+	testRandomSizes();
+	testChainReachesOnePixel();
+	return finishChecks();
+}
@@ -0,0 +1,178 @@
+#include "Physics.h"
+#include "Check.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace {
+	const float DT = 1.0f / 60;
+
+	bool sameBits(float a, float b) {
+		uint32_t bitsA, bitsB;
+		std::memcpy(&bitsA, &a, sizeof(a));
+		std::memcpy(&bitsB, &b, sizeof(b));
+		return bitsA == bitsB;
+	}
+
+	bool sameBits(const glm::vec3& a, const glm::vec3& b) {
+		return sameBits(a.x, b.x) && sameBits(a.y, b.y) && sameBits(a.z, b.z);
+	}
+
+	/**
+	 * @brief A body in one of the situations the kernels branch on, chosen by kind.
+	 */
+	void addBody(PhysicsBodies& bodies, Entity entity, int kind, std::mt19937& random) {
+		std::uniform_real_distribution<float> speed(-20, 20);
+		std::uniform_real_distribution<float> height(0.1f, 30);
+		PhysicsBody body;
+		glm::vec3 position(speed(random), height(random), speed(random));
+		body.velocity = glm::vec3(speed(random), speed(random), speed(random));
+		switch (kind) {
+		case 0:
+			// Falling or flying.
+			break;
+		case 1:
+			// Sliding along the ground.
+			position.y = 0;
+			body.velocity.y = 0;
+			break;
+		case 2:
+			// At rest on the ground, where friction is 0 / 0 and must be thrown away.
+			position.y = 0;
+			body.velocity = glm::vec3(0);
+			break;
+		case 3:
+			// Stopped along x only.
+			position.y = 0;
+			body.velocity = glm::vec3(0, 0, speed(random));
+			break;
+		case 4:
+			// Negative zeros, which compare equal to zero.
+			position.y = -0.0f;
+			body.velocity = glm::vec3(-0.0f, 0, -0.0f);
+			break;
+		case 5:
+			// Massless, which keeps its acceleration, below the ground.
+			body.mass = 0;
+			body.acceleration = glm::vec3(1, 2, 3);
+			position.y = -height(random);
+			break;
+		case 6:
+			// Massless on the ground.
+			body.mass = 0;
+			position.y = 0;
+			break;
+		case 7:
+			// Sunk below the ground with mass, which snaps it up.
+			position.y = -height(random);
+			body.mass = 5;
+			break;
+		default:
+			break;
+		}
+		body.force = PhysicsBody::GRAVITATIONAL_ACCELERATION * body.mass;
+		bodies.insert(entity, body);
+		bodies.setPositionAt(bodies.size() - 1, position);
+		if (kind == 8) {
+			// Pushed by more than gravity.
+			bodies.addForce(entity, glm::vec3(speed(random), speed(random), speed(random)) * 10.0f);
+		}
+	}
+
+	void fill(PhysicsBodies& bodies, size_t count, uint32_t seed) {
+		std::mt19937 random(seed);
+		for (uint32_t i = 0; i < count; i++) {
+			addBody(bodies, Entity{ i, 0 }, static_cast<int>(random() % 9), random);
+		}
+	}
+
+	/**
+	 * @brief Checks that the two sets hold exactly the same bits, reporting the first difference.
+	 */
+	bool checkSame(const PhysicsBodies& scalar, const PhysicsBodies& avx, size_t count, int step) {
+		for (size_t i = 0; i < count; i++) {
+			auto entity = scalar.entities()[i];
+			auto a = scalar.get(entity);
+			auto b = avx.get(entity);
+			const char* field = nullptr;
+			if (!sameBits(scalar.positionAt(i), avx.positionAt(i))) {
+				field = "position";
+			}
+			else if (!sameBits(a.velocity, b.velocity)) {
+				field = "velocity";
+			}
+			else if (!sameBits(a.acceleration, b.acceleration)) {
+				field = "acceleration";
+			}
+			else if (!sameBits(a.force, b.force)) {
+				field = "force";
+			}
+			if (field != nullptr) {
+				std::ostringstream message;
+				message << count << " bodies, step " << step << ": body " << i << "'s " << field
+					<< " differs between the scalar and AVX kernels";
+				reportFailure(__FILE__, __LINE__, message.str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Both kernels leave every body with the same bits, step after step, for batch sizes
+	 * that end in every possible scalar tail.
+	 */
+	void testKernelsAgree() {
+		if (bestPhysicsKernel() != PhysicsKernel::AVX) {
+			std::cout << "This CPU has no AVX; the AVX kernel runs the scalar one" << std::endl;
+		}
+		for (size_t count : { 1, 2, 7, 8, 9, 15, 16, 17, 31, 1003 }) {
+			PhysicsBodies scalar, avx;
+			fill(scalar, count, static_cast<uint32_t>(count));
+			fill(avx, count, static_cast<uint32_t>(count));
+			for (int step = 0; step < 120; step++) {
+				integrateBodies(scalar, DT, PhysicsKernel::Scalar);
+				integrateBodies(avx, DT, PhysicsKernel::AVX);
+				if (!checkSame(scalar, avx, count, step)) {
+					break;
+				}
+			}
+		}
+	}
+
+	void testBehavior() {
+		for (auto kernel : { PhysicsKernel::Scalar, PhysicsKernel::AVX }) {
+			PhysicsBodies bodies;
+			std::mt19937 random(1);
+			// Eight of each, so the AVX kernel sees whole vectors of one kind.
+			for (uint32_t i = 0; i < 72; i++) {
+				addBody(bodies, Entity{ i, 0 }, static_cast<int>(i / 8), random);
+			}
+			integrateBodies(bodies, DT, kernel);
+			for (size_t i = 0; i < bodies.size(); i++) {
+				auto body = bodies.get(bodies.entities()[i]);
+				auto position = bodies.positionAt(i);
+				CHECK(!(position.y < 0));
+				CHECK(std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z));
+				// Forces are cleared back to gravity.
+				CHECK(sameBits(body.force, PhysicsBody::GRAVITATIONAL_ACCELERATION * body.mass));
+				int kind = static_cast<int>(i / 8);
+				if (kind == 2 || kind == 4) {
+					// A body at rest on the ground stays there.
+					CHECK_EQUAL(position.y, 0.0f);
+					CHECK_EQUAL(body.velocity.x, 0.0f);
+					CHECK_EQUAL(body.velocity.z, 0.0f);
+				}
+				if (kind == 5) {
+					CHECK(body.acceleration == glm::vec3(1, 2, 3));
+				}
+			}
+		}
+	}
+}
+
+int main() {
+	testKernelsAgree();
+	testBehavior();
+	return finishChecks();
+}
@@ -0,0 +1,193 @@
+#include "TransformKernel.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+	// Relative to the largest entry of the matrix being checked, or 1 if that is smaller. The
+	// kernels land within about 4e-7 of glm.
+	const float EPSILON = 2e-6f;
+
+	struct Transform {
+		glm::vec3 position;
+		glm::vec3 euler;
+		glm::vec3 scale;
+		glm::vec3 center;
+		glm::mat4 base;
+	};
+
+	/**
+	 * @brief The chain of glm calls objects were built with before the kernel existed.
+	 */
+	glm::mat4 composeWithGlm(const Transform& t) {
+		auto m = glm::translate(glm::mat4(1), t.position);
+		m = glm::translate(m, t.center * t.scale);
+		m = glm::rotate(m, t.euler.z, glm::vec3(0, 0, 1));
+		m = glm::rotate(m, t.euler.x, glm::vec3(1, 0, 0));
+		m = glm::rotate(m, t.euler.y, glm::vec3(0, 1, 0));
+		m = glm::scale(m, t.scale);
+		m = glm::translate(m, -t.center);
+		return m * t.base;
+	}
+
+	std::vector<Transform> randomTransforms(std::mt19937& random, size_t count) {
+		std::uniform_real_distribution<float> coordinate(-50, 50);
+		std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+		std::uniform_real_distribution<float> scale(0.1f, 4);
+		std::uniform_real_distribution<float> offset(-3, 3);
+		std::vector<Transform> transforms(count);
+		for (size_t i = 0; i < count; i++) {
+			auto& t = transforms[i];
+			t.position = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+			t.euler = glm::vec3(angle(random), angle(random), angle(random));
+			t.scale = glm::vec3(scale(random), scale(random), scale(random));
+			t.center = glm::vec3(offset(random), offset(random), offset(random));
+			// Imported models mostly have an identity base transform, but not all of them.
+			t.base = glm::mat4(1);
+			if (i % 3 != 0) {
+				t.base = glm::translate(glm::mat4(1), glm::vec3(offset(random), offset(random), offset(random)));
+				t.base = glm::rotate(t.base, angle(random), glm::normalize(glm::vec3(offset(random), offset(random), 1)));
+				t.base = glm::scale(t.base, glm::vec3(scale(random)));
+			}
+		}
+		return transforms;
+	}
+
+	TransformBatch batchOf(const std::vector<Transform>& transforms) {
+		TransformBatch batch;
+		batch.resize(transforms.size());
+		for (size_t i = 0; i < transforms.size(); i++) {
+			auto& t = transforms[i];
+			batch.set(i, t.position, orientationFromEuler(t.euler), t.scale, t.center);
+		}
+		return batch;
+	}
+
+	std::vector<TransformKernel> availableKernels() {
+		std::vector<TransformKernel> kernels;
+		for (auto kernel : { TransformKernel::Scalar, TransformKernel::SSE, TransformKernel::AVX }) {
+			if (kernel <= bestTransformKernel()) {
+				kernels.push_back(kernel);
+			}
+		}
+		return kernels;
+	}
+
+	void checkNear(const glm::mat4& actual, const glm::mat4& expected, size_t index, TransformKernel kernel) {
+		float largest = 1;
+		for (int column = 0; column < 4; column++) {
+			for (int row = 0; row < 4; row++) {
+				largest = std::max(largest, std::abs(expected[column][row]));
+			}
+		}
+		for (int column = 0; column < 4; column++) {
+			for (int row = 0; row < 4; row++) {
+				if (!(std::abs(actual[column][row] - expected[column][row]) <= EPSILON * largest)) {
+					std::ostringstream message;
+					message << "kernel " << static_cast<int>(kernel) << ", transform " << index << ", entry ["
+						<< column << "][" << row << "] is " << actual[column][row] << ", glm gives " << expected[column][row];
+					reportFailure(__FILE__, __LINE__, message.str());
+					return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Every kernel matches the glm chain, with the lanes reading and writing matrices in
+	 * shuffled order, as they do for the dirty slots of a TransformStore.
+	 */
+	void testMatchesGlm() {
+		std::mt19937 random(3);
+		auto transforms = randomTransforms(random, 1003);
+		auto batch = batchOf(transforms);
+		std::vector<uint32_t> indices(transforms.size());
+		std::iota(indices.begin(), indices.end(), 0);
+		std::shuffle(indices.begin(), indices.end(), random);
+		// Lane i composes transforms[i], but reads the base from and writes the result to indices[i].
+		std::vector<glm::mat4> bases(transforms.size());
+		for (size_t i = 0; i < transforms.size(); i++) {
+			bases[indices[i]] = transforms[i].base;
+		}
+
+		for (auto kernel : availableKernels()) {
+			std::vector<glm::mat4> results(transforms.size());
+			composeTransforms(batch.columns(), bases.data(), indices.data(), results.data(), kernel);
+			for (size_t i = 0; i < transforms.size(); i++) {
+				checkNear(results[indices[i]], composeWithGlm(transforms[i]), i, kernel);
+			}
+		}
+	}
+
+	void testSpecialCases() {
+		Transform identity{ glm::vec3(0), glm::vec3(0), glm::vec3(1), glm::vec3(0), glm::mat4(1) };
+		// A quarter turn about each axis, a flattened axis and a mirrored one.
+		Transform quarter{ glm::vec3(1, 2, 3), glm::vec3(glm::pi<float>() / 2), glm::vec3(2, 0, -1),
+			glm::vec3(0.5f, -1, 2), glm::mat4(1) };
+		std::vector<Transform> transforms = { identity, quarter };
+		auto batch = batchOf(transforms);
+		std::vector<uint32_t> indices = { 0, 1 };
+		std::vector<glm::mat4> bases = { identity.base, quarter.base };
+		for (auto kernel : availableKernels()) {
+			std::vector<glm::mat4> results(2);
+			composeTransforms(batch.columns(), bases.data(), indices.data(), results.data(), kernel);
+			for (size_t i = 0; i < transforms.size(); i++) {
+				checkNear(results[i], composeWithGlm(transforms[i]), i, kernel);
+			}
+		}
+	}
+
+	/**
+	 * @brief The SIMD kernels give exactly the scalar kernel's bits for every batch length, so
+	 * whichever of them handles the leftover lanes.
+	 */
+	void testKernelsAgree() {
+		std::mt19937 random(5);
+		for (size_t count = 0; count <= 40; count++) {
+			auto transforms = randomTransforms(random, count);
+			auto batch = batchOf(transforms);
+			std::vector<uint32_t> indices(count);
+			std::iota(indices.begin(), indices.end(), 0);
+			std::vector<glm::mat4> bases(count);
+			for (size_t i = 0; i < count; i++) {
+				bases[i] = transforms[i].base;
+			}
+			std::vector<glm::mat4> expected(count);
+			composeTransforms(batch.columns(), bases.data(), indices.data(), expected.data(), TransformKernel::Scalar);
+			for (auto kernel : availableKernels()) {
+				std::vector<glm::mat4> results(count);
+				composeTransforms(batch.columns(), bases.data(), indices.data(), results.data(), kernel);
+				if (count > 0 && std::memcmp(results.data(), expected.data(), count * sizeof(glm::mat4)) != 0) {
+					std::ostringstream message;
+					message << "kernel " << static_cast<int>(kernel) << " differs from the scalar kernel for "
+						<< count << " transforms";
+					reportFailure(__FILE__, __LINE__, message.str());
+				}
+			}
+		}
+	}
+
+	void testEulerRoundTrip() {
+		std::mt19937 random(9);
+		std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+		std::uniform_real_distribution<float> pitch(-1.5f, 1.5f);
+		for (int i = 0; i < 1000; i++) {
+			glm::vec3 euler(pitch(random), angle(random), angle(random));
+			auto back = eulerFromOrientation(orientationFromEuler(euler));
+			CHECK_NEAR(back.x, euler.x, 1e-3);
+			CHECK_NEAR(back.y, euler.y, 1e-3);
+			CHECK_NEAR(back.z, euler.z, 1e-3);
+		}
+	}
+}
+
+int main() {
+	testMatchesGlm();
+	testSpecialCases();
+	testKernelsAgree();
+	testEulerRoundTrip();
+	return finishChecks();
+}
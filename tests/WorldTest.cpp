@@ -0,0 +1,416 @@
+#include "ComponentArray.h"
+#include "FixedTimestep.h"
+#include "TransformStore.h"
+#include "Check.h"
+#include <algorithm>
+#include <random>
+
+/**
+ * Tests for the parts the World is built from that need no GL: component storage, the
+ * transform store's entities and cached world matrices, and the fixed simulation step with the
+ * interpolation between steps.
+ */
+
+namespace {
+	std::ostream& operator<<(std::ostream& out, const Entity& entity) {
+		return out << "{" << entity.index << ", " << entity.generation << "}";
+	}
+
+	void testComponentArraySwapRemove() {
+		ComponentArray<int> array;
+		Entity a{ 0, 0 }, b{ 1, 0 }, c{ 5, 0 };
+		array.insert(a, 10);
+		array.insert(b, 20);
+		array.insert(c, 30);
+		CHECK_EQUAL(array.size(), size_t(3));
+
+		// The last component fills the gap, and its lookup follows it.
+		array.remove(a);
+		CHECK_EQUAL(array.size(), size_t(2));
+		CHECK(!array.contains(a));
+		CHECK(array.find(a) == nullptr);
+		CHECK_EQUAL(array.components()[0], 30);
+		CHECK_EQUAL(array.entities()[0], c);
+		CHECK_EQUAL(array.get(c), 30);
+		CHECK_EQUAL(array.get(b), 20);
+
+		// Removing the last one moves nothing.
+		array.remove(b);
+		CHECK_EQUAL(array.size(), size_t(1));
+		CHECK_EQUAL(array.get(c), 30);
+
+		// Removing what isn't there is allowed and changes nothing.
+		array.remove(a);
+		array.remove(Entity{ 100, 0 });
+		CHECK_EQUAL(array.size(), size_t(1));
+		CHECK_THROWS(array.get(a), std::out_of_range);
+
+		// Inserting again replaces rather than duplicating.
+		array.insert(c, 31);
+		CHECK_EQUAL(array.size(), size_t(1));
+		CHECK_EQUAL(array.get(c), 31);
+	}
+
+	void testComponentArrayStaleHandles() {
+		ComponentArray<int> array;
+		Entity old{ 3, 0 };
+		Entity reused{ 3, 1 };
+		array.insert(old, 1);
+		CHECK(!array.contains(reused));
+		CHECK(array.find(reused) == nullptr);
+		// A stale handle can't remove the component of the entity that now has its index.
+		array.remove(old);
+		array.insert(reused, 2);
+		array.remove(old);
+		CHECK(array.contains(reused));
+		CHECK_EQUAL(array.get(reused), 2);
+		CHECK(!array.contains(old));
+		CHECK_THROWS(array.get(old), std::out_of_range);
+	}
+
+	void testTransformStoreGenerations() {
+		TransformStore store;
+		auto a = store.create(glm::mat4(1));
+		auto b = store.create(glm::mat4(1));
+		auto child = store.create(glm::mat4(1));
+		store.attach(a, child);
+		CHECK(store.isAlive(a));
+		CHECK(store.isAlive(child));
+
+		// Destroying a node retires its whole subtree, and the others keep their entities.
+		store.destroy(a);
+		CHECK(!store.isAlive(a));
+		CHECK(!store.isAlive(child));
+		CHECK(store.isAlive(b));
+		CHECK_EQUAL(store.size(), size_t(1));
+		CHECK_EQUAL(store.entityAt(store.slotOf(b)), b);
+
+		// New entities reuse the freed indices, but with the next generation.
+		auto c = store.create(glm::mat4(1));
+		auto d = store.create(glm::mat4(1));
+		CHECK(c.index == a.index || c.index == child.index);
+		CHECK(d.index == a.index || d.index == child.index);
+		for (auto entity : { c, d }) {
+			auto& retired = entity.index == a.index ? a : child;
+			CHECK_EQUAL(entity.generation, retired.generation + 1);
+			CHECK(store.isAlive(entity));
+		}
+		CHECK(!store.isAlive(a));
+		CHECK(!store.isAlive(child));
+
+		// A fresh index starts at generation 0.
+		auto e = store.create(glm::mat4(1));
+		CHECK_EQUAL(e.generation, uint32_t(0));
+		CHECK(!store.isAlive(Entity{ 1000, 0 }));
+	}
+
+	/**
+	 * @brief The node's world matrix computed from scratch with glm, walking up to its root.
+	 */
+	glm::mat4 recomputeWorld(const TransformStore& store, size_t slot) {
+		auto scale = store.scaleAt(slot);
+		auto center = store.centerAt(slot);
+		auto local = glm::translate(glm::mat4(1), store.positionAt(slot) + center * scale)
+			* glm::mat4_cast(store.orientationAt(slot)) * glm::scale(glm::mat4(1), scale)
+			* glm::translate(glm::mat4(1), -center) * store.baseTransformAt(slot);
+		auto parent = store.parentAt(slot);
+		return parent == TransformStore::NO_PARENT ? local : recomputeWorld(store, parent) * local;
+	}
+
+	/**
+	 * @brief Checks the slot layout (parents before children, subtrees contiguous) and that every
+	 * world matrix matches a full recompute. Returns false after the first mismatch.
+	 */
+	bool checkAgainstRecompute(const TransformStore& store, int step) {
+		for (size_t slot = 0; slot < store.size(); slot++) {
+			CHECK(store.isAlive(store.entityAt(slot)));
+			CHECK_EQUAL(store.slotOf(store.entityAt(slot)), slot);
+			auto parent = store.parentAt(slot);
+			if (parent != TransformStore::NO_PARENT) {
+				CHECK(parent < slot);
+				CHECK(slot + store.subtreeSizeAt(slot) <= parent + store.subtreeSizeAt(parent));
+			}
+
+			auto expected = recomputeWorld(store, slot);
+			auto& actual = store.worldAt(slot);
+			float largest = 1;
+			for (int column = 0; column < 4; column++) {
+				for (int row = 0; row < 4; row++) {
+					largest = std::max(largest, std::abs(expected[column][row]));
+				}
+			}
+			for (int column = 0; column < 4; column++) {
+				for (int row = 0; row < 4; row++) {
+					if (!(std::abs(actual[column][row] - expected[column][row]) <= 1e-4f * largest)) {
+						std::ostringstream message;
+						message << "step " << step << ", slot " << slot << ": world [" << column << "][" << row << "] is "
+							<< actual[column][row] << ", recomputing gives " << expected[column][row];
+						reportFailure(__FILE__, __LINE__, message.str());
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Random edits, creates, attaches, clones and destroys, with the incrementally
+	 * maintained world matrices compared against a full recompute after every updateWorld.
+	 */
+	void testUpdateWorldMatchesRecompute() {
+		std::mt19937 random(17);
+		std::uniform_real_distribution<float> coordinate(-5, 5);
+		std::uniform_real_distribution<float> unit(-1, 1);
+		std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+		auto pick = [&](const std::vector<Entity>& entities) {
+			return entities[random() % entities.size()];
+		};
+
+		TransformStore store;
+		std::vector<Entity> live;
+		for (int i = 0; i < 20; i++) {
+			live.push_back(store.create(glm::mat4(1)));
+		}
+		for (int step = 0; step < 4000; step++) {
+			switch (random() % 10) {
+			case 0:
+				store.setPositionAt(store.slotOf(pick(live)), glm::vec3(coordinate(random), coordinate(random), coordinate(random)));
+				break;
+			case 1:
+				store.setOrientationAt(store.slotOf(pick(live)),
+					glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random))));
+				break;
+			case 2:
+				store.setScaleAt(store.slotOf(pick(live)), glm::vec3(scale(random), scale(random), scale(random)));
+				break;
+			case 3: {
+				// Setting a value a node already has must not mark it dirty.
+				auto slot = store.slotOf(pick(live));
+				store.setCenterAt(slot, random() % 2 ? store.centerAt(slot) : glm::vec3(unit(random), unit(random), unit(random)));
+				break;
+			}
+			case 4: {
+				auto base = glm::mat4(1);
+				if (random() % 2) {
+					base = glm::translate(base, glm::vec3(unit(random), unit(random), unit(random)));
+					base = glm::scale(base, glm::vec3(scale(random)));
+				}
+				live.push_back(store.create(base));
+				break;
+			}
+			case 5: {
+				auto parent = pick(live);
+				auto child = pick(live);
+				auto childSlot = store.slotOf(child);
+				auto parentSlot = store.slotOf(parent);
+				bool isRoot = store.parentAt(childSlot) == TransformStore::NO_PARENT;
+				bool ownDescendant = parentSlot >= childSlot && parentSlot < childSlot + store.subtreeSizeAt(childSlot);
+				if (isRoot && !ownDescendant) {
+					store.attach(parent, child);
+				}
+				else {
+					CHECK_THROWS(store.attach(parent, child), std::logic_error);
+				}
+				break;
+			}
+			case 6:
+				if (live.size() > 10) {
+					store.destroy(pick(live));
+					live.erase(std::remove_if(live.begin(), live.end(), [&](Entity entity) { return !store.isAlive(entity); }),
+						live.end());
+				}
+				break;
+			case 7: {
+				auto root = pick(live);
+				if (store.parentAt(store.slotOf(root)) == TransformStore::NO_PARENT && store.size() < 300) {
+					auto copy = store.slotOf(store.clone(root));
+					for (size_t i = 0; i < store.subtreeSizeAt(copy); i++) {
+						live.push_back(store.entityAt(copy + i));
+					}
+				}
+				break;
+			}
+			default:
+				store.updateWorld();
+				if (!checkAgainstRecompute(store, step)) {
+					return;
+				}
+				// Nothing changed since, so nothing is rebuilt.
+				CHECK_EQUAL(store.updateWorld(), size_t(0));
+				break;
+			}
+		}
+	}
+
+	/**
+	 * @brief updateWorld rebuilds exactly the changed nodes' subtrees, each only once.
+	 */
+	void testUpdateWorldVisitsOnlyChanged() {
+		TransformStore store;
+		auto root = store.create(glm::mat4(1));
+		std::vector<Entity> middles, leaves;
+		for (int i = 0; i < 3; i++) {
+			middles.push_back(store.create(glm::mat4(1)));
+			store.attach(root, middles.back());
+			for (int j = 0; j < 2; j++) {
+				leaves.push_back(store.create(glm::mat4(1)));
+				store.attach(middles.back(), leaves.back());
+			}
+		}
+		auto other = store.create(glm::mat4(1));
+		CHECK_EQUAL(store.updateWorld(), size_t(11));
+		CHECK_EQUAL(store.updateWorld(), size_t(0));
+
+		store.setPositionAt(store.slotOf(leaves[3]), glm::vec3(1, 0, 0));
+		CHECK_EQUAL(store.updateWorld(), size_t(1));
+		store.setScaleAt(store.slotOf(middles[1]), glm::vec3(2));
+		CHECK_EQUAL(store.updateWorld(), size_t(3));
+		store.setOrientationAt(store.slotOf(root), glm::angleAxis(1.0f, glm::vec3(0, 1, 0)));
+		CHECK_EQUAL(store.updateWorld(), size_t(10));
+
+		// A node inside a changed subtree is rebuilt with it, not again.
+		store.setPositionAt(store.slotOf(leaves[0]), glm::vec3(0, 1, 0));
+		store.setPositionAt(store.slotOf(middles[0]), glm::vec3(0, 2, 0));
+		store.setPositionAt(store.slotOf(other), glm::vec3(0, 3, 0));
+		CHECK_EQUAL(store.updateWorld(), size_t(4));
+
+		// Setting the same values changes nothing.
+		store.setPositionAt(store.slotOf(other), glm::vec3(0, 3, 0));
+		store.setScaleAt(store.slotOf(middles[1]), glm::vec3(2));
+		CHECK_EQUAL(store.updateWorld(), size_t(0));
+		checkAgainstRecompute(store, 0);
+	}
+
+	void testFixedTimestep() {
+		FixedTimestep timestep(50, 4);
+		const float step = timestep.step();
+		CHECK_NEAR(step, 0.02f, 1e-7f);
+		CHECK_EQUAL(timestep.advance(0), 0);
+		CHECK_EQUAL(timestep.alpha(), 0.0f);
+
+		// Time short of a step is carried over, and alpha says how far into the next step it is.
+		CHECK_EQUAL(timestep.advance(step * 0.5f), 0);
+		CHECK_NEAR(timestep.alpha(), 0.5f, 1e-4f);
+		CHECK_EQUAL(timestep.advance(step * 0.75f), 1);
+		CHECK_NEAR(timestep.alpha(), 0.25f, 1e-4f);
+		CHECK_EQUAL(timestep.advance(step * 3), 3);
+		CHECK_NEAR(timestep.alpha(), 0.25f, 1e-4f);
+
+		// A frame that falls more than the cap behind runs only the cap. Of the 6.5 steps it owes
+		// after that, the whole ones are dropped and the fraction is kept.
+		CHECK_EQUAL(timestep.advance(step * 10.25f), 4);
+		CHECK_NEAR(timestep.alpha(), 0.5f, 1e-3f);
+		CHECK_EQUAL(timestep.advance(step * 0.25f), 0);
+		CHECK_NEAR(timestep.alpha(), 0.75f, 1e-3f);
+
+		// However long a frame took, the next one starts less than a step behind.
+		CHECK_EQUAL(timestep.advance(10), 4);
+		CHECK(timestep.alpha() < 1);
+		CHECK_EQUAL(timestep.advance(0), 0);
+
+		// Changing the rate keeps the time carried over, now measured in the new steps.
+		FixedTimestep changed(10, 4);
+		CHECK_EQUAL(changed.advance(0.05f), 0);
+		changed.setRate(20);
+		CHECK_NEAR(changed.step(), 0.05f, 1e-7f);
+		CHECK_NEAR(changed.alpha(), 1.0f, 1e-4f);
+		CHECK_EQUAL(changed.advance(0.06f), 2);
+		CHECK_NEAR(changed.alpha(), 0.2f, 1e-3f);
+
+		CHECK_THROWS(timestep.setRate(0), std::invalid_argument);
+		CHECK_THROWS(timestep.setRate(-60), std::invalid_argument);
+		CHECK_THROWS(timestep.setRate(std::nanf("")), std::invalid_argument);
+		CHECK_THROWS(FixedTimestep(0, 4), std::invalid_argument);
+		// A rejected rate leaves the step as it was.
+		CHECK_NEAR(timestep.step(), 0.02f, 1e-7f);
+	}
+
+	void checkNear(const glm::mat4& actual, const glm::mat4& expected, const char* what) {
+		for (int column = 0; column < 4; column++) {
+			for (int row = 0; row < 4; row++) {
+				if (!(std::abs(actual[column][row] - expected[column][row]) <= 1e-4f)) {
+					std::ostringstream message;
+					message << what << ": world [" << column << "][" << row << "] is " << actual[column][row]
+						<< ", expected " << expected[column][row];
+					reportFailure(__FILE__, __LINE__, message.str());
+					return;
+				}
+			}
+		}
+	}
+
+	glm::mat4 compose(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale) {
+		return glm::translate(glm::mat4(1), position) * glm::mat4_cast(orientation) * glm::scale(glm::mat4(1), scale);
+	}
+
+	/**
+	 * @brief Nodes a step moved are drawn between their state before the step and after it, with
+	 * their subtrees following; changes made outside a step are drawn in full at once.
+	 */
+	void testUpdateWorldInterpolates() {
+		TransformStore store;
+		auto mover = store.create(glm::mat4(1));
+		auto child = store.create(glm::mat4(1));
+		store.attach(mover, child);
+		store.setPositionAt(store.slotOf(child), glm::vec3(0, 1, 0));
+		auto still = store.create(glm::mat4(1));
+		store.updateWorld();
+
+		// A teleport: alpha has nothing to interpolate.
+		store.setPositionAt(store.slotOf(mover), glm::vec3(10, 0, 0));
+		CHECK_EQUAL(store.updateWorld(0.25f), size_t(2));
+		checkNear(store.worldAt(store.slotOf(mover)), compose(glm::vec3(10, 0, 0), glm::quat(1, 0, 0, 0), glm::vec3(1)),
+			"teleported");
+
+		glm::vec3 position(20, 4, -6);
+		auto orientation = glm::angleAxis(glm::pi<float>() / 2, glm::vec3(0, 1, 0));
+		glm::vec3 scale(3, 1, 2);
+		store.beginStep();
+		store.setPositionAt(store.slotOf(mover), position);
+		store.setOrientationAt(store.slotOf(mover), orientation);
+		store.setScaleAt(store.slotOf(mover), scale);
+		store.endStep();
+		for (float alpha : { 0.0f, 0.25f, 0.5f, 1.0f }) {
+			// Drawn somewhere new every frame, with its subtree.
+			CHECK_EQUAL(store.updateWorld(alpha), size_t(2));
+			auto expected = compose(glm::mix(glm::vec3(10, 0, 0), position, alpha),
+				glm::slerp(glm::quat(1, 0, 0, 0), orientation, alpha), glm::mix(glm::vec3(1), scale, alpha));
+			checkNear(store.worldAt(store.slotOf(mover)), expected, "moved");
+			checkNear(store.worldAt(store.slotOf(child)), expected * glm::translate(glm::mat4(1), glm::vec3(0, 1, 0)),
+				"child of moved");
+		}
+		checkNear(store.worldAt(store.slotOf(still)), glm::mat4(1), "still");
+
+		// Teleported after a step moved it: the new position is drawn in full, not interpolated.
+		store.setPositionAt(store.slotOf(mover), glm::vec3(50, 0, 0));
+		store.updateWorld(0.5f);
+		CHECK_NEAR(store.worldAt(store.slotOf(mover))[3].x, 50.0f, 1e-4f);
+
+		// A step that doesn't move it leaves it where the last one did, and then it costs nothing.
+		store.beginStep();
+		store.endStep();
+		CHECK_EQUAL(store.updateWorld(0.5f), size_t(2));
+		auto settled = compose(glm::vec3(50, 0, 0), orientation, scale);
+		checkNear(store.worldAt(store.slotOf(mover)), settled, "settled");
+		CHECK_EQUAL(store.updateWorld(0.75f), size_t(0));
+		checkNear(store.worldAt(store.slotOf(mover)), settled, "settled");
+
+		// Setting a value a node already has, within a step, doesn't count as moving.
+		store.beginStep();
+		store.setPositionAt(store.slotOf(mover), glm::vec3(50, 0, 0));
+		store.endStep();
+		CHECK_EQUAL(store.updateWorld(0.5f), size_t(0));
+	}
+}
+
+int main() {
+	testComponentArraySwapRemove();
+	testComponentArrayStaleHandles();
+	testTransformStoreGenerations();
+	testUpdateWorldMatchesRecompute();
+	testUpdateWorldVisitsOnlyChanged();
+	testFixedTimestep();
+	testUpdateWorldInterpolates();
+	return finishChecks();
+}